@@ -1,9 +1,50 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 #include <glm/gtc/type_ptr.hpp>
 
 #include "glad/glad.h"
 
 #include "BSplineCurve.h"
 
+BSplineCurve::BSplineCurve()
+{
+	m_ControlPoints = m_Points.data();
+	m_PointCount = m_Points.size();
+	ResetWindow();
+}
+
+bool BSplineCurve::Load(const std::string& filename)
+{
+	bool valid = m_PathFile.Open(filename) && m_PathFile.GetSize() >= sizeof(PathHeader);
+	if (valid)
+	{
+		const auto* header = reinterpret_cast<const PathHeader*>(m_PathFile.GetData());
+		valid = std::memcmp(header->magic, "BSPL", 4) == 0 && header->version == s_PathVersion &&
+				header->pointCount >= Curve::PointsPerSegment &&
+				(m_PathFile.GetSize() - sizeof(PathHeader)) / sizeof(glm::vec3) >=
+					header->pointCount;
+		if (valid)
+		{
+			m_ControlPoints =
+				reinterpret_cast<const glm::vec3*>(m_PathFile.GetData() + sizeof(PathHeader));
+			m_PointCount = static_cast<size_t>(header->pointCount);
+		}
+	}
+	if (!valid)
+	{
+		m_PathFile.Close();
+		m_ControlPoints = m_Points.data();
+		m_PointCount = m_Points.size();
+	}
+
+	m_CurrentPoint = 0;
+	m_CurrentT = 0;
+	ResetWindow();
+	return valid;
+}
+
 void BSplineCurve::OnUpdate(float ms)
 {
 	m_CurrentT += ms * m_Velocity;
@@ -11,41 +52,48 @@ void BSplineCurve::OnUpdate(float ms)
 	{
 		m_CurrentT -= 1.f;
 		m_CurrentPoint++;
-		if (m_CurrentPoint >= m_Points.size() - 3) m_CurrentPoint = 0;
+		if (m_CurrentPoint >= m_SegmentCount)
+		{
+			m_CurrentPoint = 0;
+			ResetWindow();
+		}
+		else
+		{
+			AdvanceWindow();
+		}
 	}
 }
 
 void BSplineCurve::Render()
 {
 	glBegin(GL_LINE_STRIP);
-	for (size_t i = 0; i < m_Points.size() - 3; i++)
-		for (float t = 0.f; t < 1.f; t += m_Step)
-			glVertex3fv(glm::value_ptr(
-				GetCurvePoint(m_Points[i], m_Points[i + 1], m_Points[i + 2], m_Points[i + 3], t)));
+	for (const auto& segment : m_Window)
+		for (const auto& sample : segment.samples)
+			glVertex3fv(glm::value_ptr(sample));
 	glEnd();
 }
 
 void BSplineCurve::RenderControlPoints()
 {
+	size_t first = Curve::GetFirstPoint(m_WindowStart);
+	size_t last = Curve::GetFirstPoint(m_WindowStart + m_Window.size() - 1) +
+				  Curve::PointsPerSegment;
 	glBegin(GL_POINTS);
-	for (const auto& point : m_Points)
-		glVertex3fv(glm::value_ptr(point));
+	for (size_t i = first; i < last; i++)
+		glVertex3fv(glm::value_ptr(m_ControlPoints[i]));
 	glEnd();
 }
 
 void BSplineCurve::RenderNormals()
 {
 	glBegin(GL_LINES);
-	for (size_t i = 0; i < m_Points.size() - 3; i++)
+	for (const auto& segment : m_Window)
 	{
-		for (float t = 0.f; t < 1.f; t += m_Step)
+		for (size_t i = 0; i < segment.samples.size(); i++)
 		{
-			glm::vec3 point =
-				GetCurvePoint(m_Points[i], m_Points[i + 1], m_Points[i + 2], m_Points[i + 3], t);
-			glm::vec3 normal = GetSecondDerivative(m_Points[i], m_Points[i + 1], m_Points[i + 2],
-												   m_Points[i + 3], t);
-			glVertex3fv(glm::value_ptr(point));
-			glVertex3fv(glm::value_ptr(point + normal));
+			glm::vec3 normal = segment.frames[i] * glm::vec3(0.f, 1.f, 0.f);
+			glVertex3fv(glm::value_ptr(segment.samples[i]));
+			glVertex3fv(glm::value_ptr(segment.samples[i] + normal));
 		}
 	}
 	glEnd();
@@ -53,46 +101,133 @@ void BSplineCurve::RenderNormals()
 
 glm::mat4 BSplineCurve::GetObjectModelMatrix()
 {
-	glm::mat4 model = glm::translate(
-		glm::mat4(1.f),
-		GetCurvePoint(m_Points[m_CurrentPoint], m_Points[m_CurrentPoint + 1],
-					  m_Points[m_CurrentPoint + 2], m_Points[m_CurrentPoint + 3], m_CurrentT));
-	glm::vec3 z =
-		GetFirstDerivative(m_Points[m_CurrentPoint], m_Points[m_CurrentPoint + 1],
-						   m_Points[m_CurrentPoint + 2], m_Points[m_CurrentPoint + 3], m_CurrentT);
-	glm::vec3 y =
-		GetSecondDerivative(m_Points[m_CurrentPoint], m_Points[m_CurrentPoint + 1],
-							m_Points[m_CurrentPoint + 2], m_Points[m_CurrentPoint + 3], m_CurrentT);
-	glm::vec3 x = glm::normalize(glm::cross(y, z));
-	glm::mat4 rot(x[0], y[0], z[0], 0, x[1], y[1], z[1], 0, x[2], y[2], z[2], 0, 0, 0, 0, 1);
-	return model * glm::inverse(rot);
+	glm::mat4 model = glm::translate(glm::mat4(1.f), GetCurvePoint(m_CurrentPoint, m_CurrentT));
+	return model * glm::mat4_cast(GetFrame(m_CurrentPoint, m_CurrentT));
+}
+
+float BSplineCurve::GetDistance() const
+{
+	const BakedSegment& segment = GetBakedSegment(m_CurrentPoint);
+	float sample = glm::clamp(m_CurrentT, 0.f, 1.f) * m_SamplesPerSegment;
+	size_t index = std::min(static_cast<size_t>(sample), m_SamplesPerSegment - 1);
+	return glm::mix(segment.distances[index], segment.distances[index + 1], sample - index);
+}
+
+void BSplineCurve::ResetWindow()
+{
+	m_SegmentCount = Curve::GetSegmentCount(m_PointCount);
+	m_Window.clear();
+	m_WindowStart = m_CurrentPoint;
+	AdvanceWindow();
+}
+
+void BSplineCurve::AdvanceWindow()
+{
+	size_t end = std::min(m_SegmentCount, m_CurrentPoint + m_SegmentsAhead + 1);
+	while (m_WindowStart + m_Window.size() < end)
+		BakeSegment(m_WindowStart + m_Window.size());
+	while (m_CurrentPoint > m_WindowStart + m_SegmentsBehind)
+	{
+		m_Window.pop_front();
+		m_WindowStart++;
+	}
+}
+
+void BSplineCurve::BakeSegment(size_t segment)
+{
+	BakedSegment baked;
+	baked.samples.reserve(m_SamplesPerSegment + 1);
+	baked.frames.reserve(m_SamplesPerSegment + 1);
+	baked.distances.reserve(m_SamplesPerSegment + 1);
+
+	// Continue from the last frame of the previous segment, or start from the Frenet normal where
+	// it exists. The frame is then carried along with the double reflection method, so it neither
+	// flips at inflections nor degenerates on straight sections.
+	glm::vec3 position, tangent, normal;
+	float distance = 0.f;
+	if (!m_Window.empty())
+	{
+		const BakedSegment& previous = m_Window.back();
+		position = previous.samples.back();
+		tangent = previous.frames.back() * glm::vec3(0.f, 0.f, 1.f);
+		normal = previous.frames.back() * glm::vec3(0.f, 1.f, 0.f);
+		distance = previous.distances.back();
+	}
+	else
+	{
+		position = GetCurvePoint(segment, 0.f);
+		tangent = GetFirstDerivative(segment, 0.f);
+		normal = GetSecondDerivative(segment, 0.f);
+		normal -= glm::dot(normal, tangent) * tangent;
+		if (glm::dot(normal, normal) < 1e-6f)
+		{
+			glm::vec3 axis = std::abs(tangent.y) < 0.9f ? glm::vec3(0.f, 1.f, 0.f)
+														: glm::vec3(1.f, 0.f, 0.f);
+			normal = glm::cross(tangent, glm::cross(axis, tangent));
+		}
+		normal = glm::normalize(normal);
+	}
+
+	for (size_t i = 0; i <= m_SamplesPerSegment; i++)
+	{
+		float t = static_cast<float>(i) / m_SamplesPerSegment;
+		glm::vec3 nextPosition = GetCurvePoint(segment, t);
+		glm::vec3 nextTangent = GetFirstDerivative(segment, t);
+
+		glm::vec3 v1 = nextPosition - position;
+		float c1 = glm::dot(v1, v1);
+		if (c1 > 1e-12f)
+		{
+			glm::vec3 normalL = normal - (2.f / c1) * glm::dot(v1, normal) * v1;
+			glm::vec3 tangentL = tangent - (2.f / c1) * glm::dot(v1, tangent) * v1;
+			glm::vec3 v2 = nextTangent - tangentL;
+			float c2 = glm::dot(v2, v2);
+			normal = c2 > 1e-12f ? normalL - (2.f / c2) * glm::dot(v2, normalL) * v2 : normalL;
+		}
+		distance += std::sqrt(c1);
+		position = nextPosition;
+		tangent = nextTangent;
+		normal = glm::normalize(normal - glm::dot(normal, tangent) * tangent);
+
+		glm::vec3 binormal = glm::cross(normal, tangent);
+		baked.samples.push_back(position);
+		baked.frames.push_back(glm::quat_cast(glm::mat3(binormal, normal, tangent)));
+		baked.distances.push_back(distance);
+	}
+
+	m_Window.push_back(std::move(baked));
+}
+
+const BSplineCurve::BakedSegment& BSplineCurve::GetBakedSegment(size_t segment) const
+{
+	assert(segment >= m_WindowStart && segment < m_WindowStart + m_Window.size());
+	return m_Window[segment - m_WindowStart];
+}
+
+glm::quat BSplineCurve::GetFrame(size_t segment, float t) const
+{
+	const BakedSegment& baked = GetBakedSegment(segment);
+	float sample = glm::clamp(t, 0.f, 1.f) * m_SamplesPerSegment;
+	size_t index = std::min(static_cast<size_t>(sample), m_SamplesPerSegment - 1);
+	float alpha = sample - index;
+
+	const glm::quat& q0 = baked.frames[index];
+	glm::quat q1 = baked.frames[index + 1];
+	if (glm::dot(q0, q1) < 0.f) q1 = -q1;
+	return glm::normalize(q0 * (1.f - alpha) + q1 * alpha);
 }
 
-glm::vec3 BSplineCurve::GetCurvePoint(const glm::vec3& point1, const glm::vec3& point2,
-									  const glm::vec3& point3, const glm::vec3& point4, float t)
+glm::vec3 BSplineCurve::GetCurvePoint(size_t segment, float t) const
 {
-	glm::vec4 v = {t * t * t, t * t, t, 1};
-	glm::mat3x4 r(point1[0], point2[0], point3[0], point4[0], point1[1], point2[1], point3[1],
-				  point4[1], point1[2], point2[2], point3[2], point4[2]);
-	return v * (1.f / 6) * m0 * r;
+	return Curve::Evaluate(&m_ControlPoints[Curve::GetFirstPoint(segment)], t);
 }
 
-glm::vec3 BSplineCurve::GetFirstDerivative(const glm::vec3& point1, const glm::vec3& point2,
-										   const glm::vec3& point3, const glm::vec3& point4,
-										   float t)
+glm::vec3 BSplineCurve::GetFirstDerivative(size_t segment, float t) const
 {
-	glm::vec3 v = {t * t, t, 1};
-	glm::mat3x4 r(point1[0], point2[0], point3[0], point4[0], point1[1], point2[1], point3[1],
-				  point4[1], point1[2], point2[2], point3[2], point4[2]);
-	return glm::normalize(v * m1 * r);
+	return glm::normalize(Curve::Evaluate<1>(&m_ControlPoints[Curve::GetFirstPoint(segment)], t));
 }
 
-glm::vec3 BSplineCurve::GetSecondDerivative(const glm::vec3& point1, const glm::vec3& point2,
-											const glm::vec3& point3, const glm::vec3& point4,
-											float t)
+glm::vec3 BSplineCurve::GetSecondDerivative(size_t segment, float t) const
 {
-	glm::vec2 v = {t, 1};
-	glm::mat3x4 r(point1[0], point2[0], point3[0], point4[0], point1[1], point2[1], point3[1],
-				  point4[1], point1[2], point2[2], point3[2], point4[2]);
-	return glm::normalize(v * m2 * r);
+	return Curve::Evaluate<2>(&m_ControlPoints[Curve::GetFirstPoint(segment)], t);
 }
@@ -0,0 +1,239 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "glad/glad.h"
+
+#include "Game.h"
+#include "Profiler.h"
+#include "Spline.h"
+
+static const char* GetOptionValue(const char* argument, const char* option)
+{
+	size_t length = std::strlen(option);
+	if (std::strncmp(argument, option, length) != 0 || argument[length] != '=') return nullptr;
+	return argument + length + 1;
+}
+
+static std::string EscapeJson(const std::string& text)
+{
+	std::string result;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') result += '\\';
+		result += c;
+	}
+	return result;
+}
+
+using SplineSample = std::pair<const glm::vec3*, float>;
+
+// Times one evaluation path over every sample, best of rounds, and returns the milliseconds taken
+template<typename Evaluate>
+static float TimeSplineEvaluation(const std::vector<SplineSample>& samples, int rounds,
+								  Evaluate evaluate)
+{
+	float best = std::numeric_limits<float>::max();
+	glm::vec3 sum(0.f);
+	for (int round = 0; round < rounds; round++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const auto& [points, t] : samples)
+			sum += evaluate(points, t);
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best,
+						std::chrono::duration<float, std::chrono::milliseconds::period>(end - start)
+							.count());
+	}
+	// Keeps the evaluations from being optimized away
+	volatile float sink = sum.x + sum.y + sum.z;
+	(void)sink;
+	return best;
+}
+
+template<size_t Derivative>
+static void CompareSplineEvaluation(const char* name, const std::vector<SplineSample>& samples,
+									int rounds)
+{
+	float constexprMs = TimeSplineEvaluation(samples, rounds, [](const glm::vec3* points, float t) {
+		return CubicBSpline::Evaluate<Derivative>(points, t);
+	});
+	float matrixMs = TimeSplineEvaluation(samples, rounds, [](const glm::vec3* points, float t) {
+		return MatrixBSpline::Evaluate<Derivative>(points, t);
+	});
+
+	float difference = 0.f;
+	for (const auto& [points, t] : samples)
+	{
+		glm::vec3 delta = CubicBSpline::Evaluate<Derivative>(points, t) -
+						  MatrixBSpline::Evaluate<Derivative>(points, t);
+		difference = std::max(difference, glm::length(delta));
+	}
+
+	std::cout << "  " << name << ": constexpr " << constexprMs << " ms, matrix " << matrixMs
+			  << " ms, " << matrixMs / constexprMs << "x, max difference " << difference
+			  << std::endl;
+}
+
+bool Benchmark::ParseArguments(int argc, char** argv, BenchmarkSettings& settings)
+{
+	bool enabled = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* value = nullptr;
+		if (std::strcmp(argv[i], "--benchmark") == 0) { enabled = true; }
+		else if (std::strcmp(argv[i], "--bench-spline") == 0)
+		{
+			enabled = true;
+			settings.mode = BenchmarkMode::Spline;
+		}
+		else if ((value = GetOptionValue(argv[i], "--frames")))
+			settings.frameCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if ((value = GetOptionValue(argv[i], "--warmup")))
+			settings.warmupFrames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if ((value = GetOptionValue(argv[i], "--width")))
+			settings.width = std::max(std::atoi(value), 1);
+		else if ((value = GetOptionValue(argv[i], "--height")))
+			settings.height = std::max(std::atoi(value), 1);
+		else if ((value = GetOptionValue(argv[i], "--output")))
+			settings.outputPath = value;
+		else if ((value = GetOptionValue(argv[i], "--samples")))
+			settings.splineSamples = std::max(std::atoi(value), 1);
+		else
+			std::cout << "Ignoring unknown argument " << argv[i] << std::endl;
+	}
+	return enabled;
+}
+
+int Benchmark::Run(const std::string& title, const BenchmarkSettings& settings)
+{
+	if (settings.mode == BenchmarkMode::Spline) return RunSpline(settings);
+
+	Game::CreateGame(title, settings.width, settings.height, true);
+	Game& game = Game::Get();
+
+	// Assets stream in on worker threads, which would otherwise dominate the first frames
+	while (!game.IsLoaded() && game.IsRunning())
+	{
+		game.Update(0.f);
+		game.Render();
+	}
+
+	std::vector<float> frameTimes;
+	frameTimes.reserve(settings.frameCount);
+	uint32_t totalFrames = settings.warmupFrames + settings.frameCount;
+	for (uint32_t frame = 0; frame < totalFrames && game.IsRunning(); frame++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		Profiler::BeginFrame();
+		game.Update(s_FrameStep);
+		glm::vec3 position, target;
+		GetCameraPose(frame, totalFrames, position, target);
+		game.SetCameraPose(position, target);
+		game.Render();
+		glFinish();
+		Profiler::EndFrame();
+		auto end = std::chrono::high_resolution_clock::now();
+
+		if (frame >= settings.warmupFrames)
+			frameTimes.push_back(
+				std::chrono::duration<float, std::chrono::milliseconds::period>(end - start)
+					.count());
+	}
+
+	return WriteResults(title, settings, std::move(frameTimes)) ? 0 : 1;
+}
+
+int Benchmark::RunSpline(const BenchmarkSettings& settings)
+{
+	// A wobbling helix, so neighbouring segments and their coefficients differ
+	std::vector<glm::vec3> points(64);
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		float angle = 0.5f * i;
+		points[i] = {10.f * std::cos(angle), 3.f * std::sin(1.7f * angle), 5.f * i};
+	}
+
+	// t values evenly spread along the whole curve
+	size_t segments = CubicBSpline::GetSegmentCount(points.size());
+	std::vector<SplineSample> samples(settings.splineSamples);
+	for (size_t i = 0; i < samples.size(); i++)
+	{
+		float position = static_cast<float>(i) / samples.size() * segments;
+		size_t segment = std::min(static_cast<size_t>(position), segments - 1);
+		samples[i] = {&points[CubicBSpline::GetFirstPoint(segment)], position - segment};
+	}
+
+	std::cout << "Spline benchmark: " << samples.size() << " evaluations over " << segments
+			  << " segments, best of " << s_SplineRounds << " rounds" << std::endl;
+	CompareSplineEvaluation<0>("point", samples, s_SplineRounds);
+	CompareSplineEvaluation<1>("first derivative", samples, s_SplineRounds);
+	CompareSplineEvaluation<2>("second derivative", samples, s_SplineRounds);
+	return 0;
+}
+
+void Benchmark::GetCameraPose(uint32_t frame, uint32_t frameCount, glm::vec3& position,
+							  glm::vec3& target)
+{
+	// One orbit around the flight path per run, bobbing up and down over the terrain
+	const glm::vec3 center{5.f, 5.f, 27.5f};
+	const float radius = 60.f;
+	float angle = glm::two_pi<float>() * frame / std::max(frameCount, 1u);
+	position = center + glm::vec3(radius * std::cos(angle), 10.f + 8.f * std::sin(2.f * angle),
+								  radius * std::sin(angle));
+	target = center;
+}
+
+bool Benchmark::WriteResults(const std::string& title, const BenchmarkSettings& settings,
+							 std::vector<float> frameTimes)
+{
+	if (frameTimes.empty())
+	{
+		std::cout << "Benchmark: no frames were measured" << std::endl;
+		return false;
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	size_t count = frameTimes.size();
+	float mean = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.f) / count;
+	auto getPercentile = [&frameTimes, count](float percentile) {
+		// Nearest rank
+		size_t rank = static_cast<size_t>(std::ceil(percentile / 100.f * count));
+		return frameTimes[std::clamp<size_t>(rank, 1, count) - 1];
+	};
+
+	const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+	std::ofstream fs(settings.outputPath, std::ios::trunc);
+	if (!fs)
+	{
+		std::cout << "Benchmark: cannot write " << settings.outputPath << std::endl;
+		return false;
+	}
+	fs << "{\n";
+	fs << "  \"title\": \"" << EscapeJson(title) << "\",\n";
+	fs << "  \"renderer\": \"" << EscapeJson(renderer ? renderer : "") << "\",\n";
+	fs << "  \"version\": \"" << EscapeJson(version ? version : "") << "\",\n";
+	fs << "  \"width\": " << settings.width << ",\n";
+	fs << "  \"height\": " << settings.height << ",\n";
+	fs << "  \"frames\": " << count << ",\n";
+	fs << "  \"mean_ms\": " << mean << ",\n";
+	fs << "  \"p50_ms\": " << getPercentile(50.f) << ",\n";
+	fs << "  \"p95_ms\": " << getPercentile(95.f) << ",\n";
+	fs << "  \"p99_ms\": " << getPercentile(99.f) << ",\n";
+	fs << "  \"max_ms\": " << frameTimes.back() << "\n";
+	fs << "}\n";
+
+	std::cout << "Benchmark: " << count << " frames, mean " << mean << " ms, p99 "
+			  << getPercentile(99.f) << " ms, written to " << settings.outputPath << std::endl;
+	return static_cast<bool>(fs);
+}
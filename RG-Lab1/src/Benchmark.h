@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+enum class BenchmarkMode
+{
+	Frames,
+	Spline
+};
+
+struct BenchmarkSettings
+{
+	BenchmarkMode mode = BenchmarkMode::Frames;
+	uint32_t frameCount = 1000;
+	// Rendered before measuring starts, once asynchronous loading has finished
+	uint32_t warmupFrames = 60;
+	int width = 1280;
+	int height = 720;
+	std::string outputPath = "benchmark.json";
+	// Curve evaluations per round of the spline benchmark
+	uint32_t splineSamples = 1 << 20;
+};
+
+// Headless performance run: the game renders into an offscreen framebuffer of an invisible window
+// while the camera follows a scripted orbit, and frame time statistics are written as JSON.
+//   --benchmark [--frames=N] [--warmup=N] [--width=W] [--height=H] [--output=file.json]
+// Every frame is finished with glFinish so GPU work is part of the measured time.
+//   --bench-spline [--samples=N]
+// times the constexpr Spline evaluation against the matrix reference on the CPU, without a window.
+class Benchmark
+{
+private:
+	Benchmark() = default;
+
+public:
+	Benchmark(const Benchmark&) = delete;
+	Benchmark& operator=(const Benchmark&) = delete;
+
+	// Returns true when --benchmark or --bench-spline was given, settings are filled from the
+	// remaining options
+	static bool ParseArguments(int argc, char** argv, BenchmarkSettings& settings);
+	// Returns the process exit code
+	static int Run(const std::string& title, const BenchmarkSettings& settings);
+
+private:
+	static int RunSpline(const BenchmarkSettings& settings);
+	static void GetCameraPose(uint32_t frame, uint32_t frameCount, glm::vec3& position,
+							  glm::vec3& target);
+	static bool WriteResults(const std::string& title, const BenchmarkSettings& settings,
+							 std::vector<float> frameTimes);
+
+private:
+	// Simulation step per frame, fixed so every run renders the same frames
+	static constexpr float s_FrameStep = 1000.f / 60.f;
+	// The spline benchmark reports the fastest of this many rounds
+	static constexpr int s_SplineRounds = 5;
+};
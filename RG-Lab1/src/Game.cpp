@@ -7,18 +7,24 @@
 
 #include "Game.h"
 #include "Input.h"
+#include "Profiler.h"
+#include "TextureCache.h"
 
 std::unique_ptr<Game> Game::s_Game;
 
-Game::Game(const std::string& title, int width, int height)
-	: m_CameraController((float)width / height)
+Game::Game(const std::string& title, int width, int height, bool headless)
+	: m_Headless(headless)
+	, m_Title(title)
+	, m_CameraController((float)width / height)
 {
 	auto result = glfwInit();
 	assert(result);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
-	glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+	glfwWindowHint(GLFW_RESIZABLE, headless ? GL_FALSE : GL_TRUE);
+	// GLFW 3.3 cannot create a context without a window, a hidden one stands in for it
+	glfwWindowHint(GLFW_VISIBLE, headless ? GL_FALSE : GL_TRUE);
 	m_Window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
 	assert(m_Window);
 	glfwMakeContextCurrent(m_Window);
@@ -30,24 +36,75 @@ Game::Game(const std::string& title, int width, int height)
 	result = gladLoadGL();
 	assert(result);
 
+	if (m_Headless)
+	{
+		// The default framebuffer of a hidden window may not be backed by pixels
+		glGenRenderbuffers(1, &m_ColorRenderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_ColorRenderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+		glGenRenderbuffers(1, &m_DepthRenderbuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+		glGenFramebuffers(1, &m_Framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+								  m_ColorRenderbuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+								  m_DepthRenderbuffer);
+		assert(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	}
+
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(1.f, 1.f, 1.f, 1.f);
 	glViewport(0, 0, width, height);
+
+	m_CameraBuffer.Create(sizeof(CameraUniforms), s_CameraBinding);
 	glLineWidth(3);
 	glPointSize(10);
 
-	m_Object.Load("models/f16.obj", 2.f, {255, 0, 0, 255}, "");
-	m_Land.Load("models/mountain.fbx", 100.f, {255, 0, 0, 255}, "textures/Normal.tga");
-	m_Skydome.Load("models/dome.obj", 5000.f, {255, 0, 0, 255}, "");
+	m_Object.SetBatch(&m_StaticBatch);
+	m_Land.SetBatch(&m_StaticBatch);
+	m_Object.LoadAsync(m_AssetLoader, "models/f16.obj", 2.f, {255, 0, 0, 255}, "",
+					   VertexFormat::Quantized);
+	m_Land.LoadAsync(m_AssetLoader, "models/mountain.fbx", 100.f, {255, 0, 0, 255},
+					 "textures/Normal.tga", VertexFormat::Quantized);
+	m_Skydome.LoadAsync(m_AssetLoader, "models/dome.obj", 5000.f, {255, 0, 0, 255}, "",
+						VertexFormat::Quantized);
+
+	// Replay a recorded flight path when one is present, otherwise keep the built-in curve
+	m_BSpline.Load("paths/flight.bin");
 
-	m_ObjectShader.Load("src/shaders/vertex.glsl", "src/shaders/fragment.glsl");
-	m_LandShader.Load("src/shaders/vertex.glsl", "src/shaders/fragment_land.glsl");
+	m_BatchShader.Load("src/shaders/vertex_batch.glsl", "src/shaders/fragment_batch.glsl");
 	m_SkydomeShader.Load("src/shaders/vertex_skydome.glsl", "src/shaders/fragment_skydome.glsl");
 	m_MarkerShader.Load("src/shaders/vertex_marker.glsl", "src/shaders/fragment_marker.glsl");
+
+	// Sampler units never change, set them once instead of every frame
+	m_BatchShader.Use();
+	m_BatchShader.SetInt("textures", 0);
+	m_BatchShader.SetInt("normalTextures", 1);
 }
 
 Game::~Game()
 {
+	// Members are destroyed after the window, so the GL objects they own are deleted here while
+	// the context is still current
+	m_Object.Unload();
+	m_Land.Unload();
+	m_Skydome.Unload();
+	m_StaticBatch.Release();
+	m_CameraBuffer.Release();
+	m_BatchShader.Release();
+	m_SkydomeShader.Release();
+	m_MarkerShader.Release();
+	TextureCache::Clear();
+
+	if (m_Headless)
+	{
+		glDeleteFramebuffers(1, &m_Framebuffer);
+		glDeleteRenderbuffers(1, &m_ColorRenderbuffer);
+		glDeleteRenderbuffers(1, &m_DepthRenderbuffer);
+	}
 	glfwDestroyWindow(m_Window);
 	glfwTerminate();
 }
@@ -56,58 +113,71 @@ void Game::Update(float ms)
 {
 	m_CameraController.OnUpdate(ms);
 	m_BSpline.OnUpdate(ms);
+
+	if (m_ShowProfiler)
+	{
+		m_ProfilerRefreshTimer -= ms;
+		if (m_ProfilerRefreshTimer <= 0.f)
+		{
+			m_ProfilerRefreshTimer = m_ProfilerRefreshInterval;
+			std::string title = m_Title + " | " + Profiler::FormatResults();
+			glfwSetWindowTitle(m_Window, title.c_str());
+		}
+	}
 }
 
 void Game::Render()
 {
 	if (m_Minimized) return;
 
+	{
+		ProfileScope scope("uploads");
+		m_AssetLoader.ProcessUploads(m_UploadBudget);
+	}
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Render object
-	m_ObjectShader.Use();
-	m_ObjectShader.SetInt("tex", 0);
-	m_ObjectShader.SetMat4f("projection", m_CameraController.GetCamera().GetProjectionMatrix());
-	m_ObjectShader.SetMat4f("view", m_CameraController.GetCamera().GetViewMatrix());
-	m_ObjectShader.SetVec3f("cameraPos", m_CameraController.GetCamera().GetPosition());
-	m_ObjectShader.SetMat4f("model", m_BSpline.GetObjectModelMatrix());
-	m_Object.Render();
-
-	// Render mountains
-	m_LandShader.Use();
-	m_LandShader.SetInt("tex", 0);
-	m_LandShader.SetInt("normalMap", 1);
-	m_LandShader.SetMat4f("projection", m_CameraController.GetCamera().GetProjectionMatrix());
-	m_LandShader.SetMat4f("view", m_CameraController.GetCamera().GetViewMatrix());
-	m_LandShader.SetVec3f("cameraPos", m_CameraController.GetCamera().GetPosition());
-	m_LandShader.SetMat4f("model", glm::translate(glm::mat4(1.f), {0.f, -15.f, 0.f}));
-	m_Land.Render();
-
-	m_MarkerShader.Use();
-	m_MarkerShader.SetMat4f("projection", m_CameraController.GetCamera().GetProjectionMatrix());
-	m_MarkerShader.SetMat4f("view", m_CameraController.GetCamera().GetViewMatrix());
-	m_MarkerShader.SetMat4f("model", glm::mat4(1.f));
-
-	// Render curve
-	m_MarkerShader.SetVec3f("color", {0.f, 1.f, 0.f});
-	m_BSpline.Render();
-
-	// Render curve normals
-	m_MarkerShader.SetVec3f("color", {0.f, 0.f, 1.f});
-	m_BSpline.RenderNormals();
-
-	// Render control points
-	m_MarkerShader.SetVec3f("color", {1.f, 1.f, 0.f});
-	m_BSpline.RenderControlPoints();
-
-	// Render sky
-	m_SkydomeShader.Use();
-	m_SkydomeShader.SetMat4f("model", glm::translate(glm::mat4(1.f), {0.f, -1200.f, 0.f}));
-	m_SkydomeShader.SetMat4f("view", m_CameraController.GetCamera().GetViewMatrix());
-	m_SkydomeShader.SetMat4f("projection", m_CameraController.GetCamera().GetProjectionMatrix());
-	m_Skydome.Render();
-
-	glfwSwapBuffers(m_Window);
+	const PerspectiveCamera& camera = m_CameraController.GetCamera();
+	CameraUniforms cameraUniforms{};
+	cameraUniforms.view = camera.GetViewMatrix();
+	cameraUniforms.projection = camera.GetProjectionMatrix();
+	cameraUniforms.cameraPos = camera.GetPosition();
+	m_CameraBuffer.SetData(&cameraUniforms, sizeof(cameraUniforms));
+
+	m_Object.Submit(m_RenderQueue, m_BatchShader, camera, m_BSpline.GetObjectModelMatrix());
+	m_Land.Submit(m_RenderQueue, m_BatchShader, camera,
+				  glm::translate(glm::mat4(1.f), {0.f, -15.f, 0.f}));
+	DrawCommand batch;
+	batch.name = "static batch";
+	batch.shader = &m_BatchShader;
+	batch.draw = [this](Shader&) { m_StaticBatch.Draw(); };
+	m_RenderQueue.Submit(std::move(batch));
+	m_Skydome.Submit(m_RenderQueue, m_SkydomeShader, camera,
+					 glm::translate(glm::mat4(1.f), {0.f, -1200.f, 0.f}), RenderPass::Sky);
+
+	DrawCommand markers;
+	markers.name = "curve";
+	markers.shader = &m_MarkerShader;
+	markers.draw = [this](Shader& shader) {
+		shader.SetMat4f("model", glm::mat4(1.f));
+
+		// Render curve
+		shader.SetVec3f("color", {0.f, 1.f, 0.f});
+		m_BSpline.Render();
+
+		// Render curve normals
+		shader.SetVec3f("color", {0.f, 0.f, 1.f});
+		m_BSpline.RenderNormals();
+
+		// Render control points
+		shader.SetVec3f("color", {1.f, 1.f, 0.f});
+		m_BSpline.RenderControlPoints();
+	};
+	m_RenderQueue.Submit(std::move(markers));
+
+	m_RenderQueue.Flush();
+
+	if (!m_Headless) glfwSwapBuffers(m_Window);
 	glfwPollEvents();
 }
 
@@ -121,6 +191,61 @@ void Game::OnKeyPressed(GLFWwindow* window, int key, int scancode, int action, i
 			Input::EnableCursor();
 		}
 	}
+	if (key == GLFW_KEY_F1 && action == GLFW_PRESS) TextureCache::PrintStatistics();
+	if (key == GLFW_KEY_F2 && action == GLFW_PRESS) Get().PrintLodStatistics();
+	if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+	{
+		Get().m_RenderQueue.PrintStatistics();
+		Get().m_StaticBatch.PrintStatistics();
+	}
+	if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+	{
+		Game& game = Get();
+		game.m_ShowProfiler = !game.m_ShowProfiler;
+		game.m_ProfilerRefreshTimer = 0.f;
+		if (!game.m_ShowProfiler) glfwSetWindowTitle(game.m_Window, game.m_Title.c_str());
+	}
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+	{
+		if (Profiler::IsRecordingCsv())
+		{
+			Profiler::StopCsv();
+			std::cout << "Profiler: stopped recording" << std::endl;
+		}
+		else if (Profiler::StartCsv("profile.csv"))
+		{
+			std::cout << "Profiler: recording to profile.csv" << std::endl;
+		}
+	}
+}
+
+void Game::PrintLodStatistics() const
+{
+	std::pair<const char*, const Entity*> entities[] = {
+		{"object", &m_Object}, {"land", &m_Land}, {"skydome", &m_Skydome}};
+	size_t drawn = 0, full = 0;
+	for (const auto& [name, entity] : entities)
+	{
+		if (entity->GetLodCount() == 0) continue;
+		drawn += entity->GetTriangleCount(entity->GetLod());
+		full += entity->GetTriangleCount(0);
+	}
+
+	std::cout << "LOD: " << drawn << " of " << full << " triangles drawn" << std::endl;
+	for (const auto& [name, entity] : entities)
+	{
+		if (entity->GetLodCount() == 0) continue;
+		std::cout << "  " << name << ": level " << entity->GetLod() << " of "
+				  << entity->GetLodCount() << ", " << entity->GetTriangleCount(entity->GetLod())
+				  << " of " << entity->GetTriangleCount(0) << " triangles, "
+				  << entity->GetIndexSize() * 8 << "-bit indices" << std::endl;
+		const ImportStatistics& statistics = entity->GetImportStatistics();
+		if (statistics.optimized)
+		{
+			std::cout << "    optimized at import, ACMR " << statistics.acmrBefore << " -> "
+					  << statistics.acmrAfter << std::endl;
+		}
+	}
 }
 
 void Game::OnWindowResized(GLFWwindow* window, int width, int height)
@@ -0,0 +1,115 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const char* s_CacheDirectory = "cache/meshes";
+
+bool MeshCache::Open(const Key& key)
+{
+	int64_t sourceTime = GetSourceTime(key.filename);
+	if (!m_File.Open(GetCachePath(key)) || m_File.GetSize() < sizeof(Header))
+		return false;
+
+	const auto* header = reinterpret_cast<const Header*>(m_File.GetData());
+	size_t dataOffset = GetDataOffset(*header);
+	const char* sourcePath = reinterpret_cast<const char*>(m_File.GetData() + sizeof(Header));
+	bool valid = std::memcmp(header->magic, "MESH", 4) == 0 && header->version == s_Version &&
+				 header->sourceTime == sourceTime && header->importFlags == key.importFlags &&
+				 header->scale == key.scale && header->sourcePathLength == key.filename.size() &&
+				 (header->indexSize == sizeof(uint16_t) || header->indexSize == sizeof(uint32_t)) &&
+				 m_File.GetSize() >= dataOffset + header->vertexCount * sizeof(Vertex) +
+										 header->lodCount * sizeof(MeshLod) +
+										 header->indexCount * header->indexSize &&
+				 std::memcmp(sourcePath, key.filename.data(), key.filename.size()) == 0;
+	if (!valid)
+	{
+		m_File.Close();
+		return false;
+	}
+
+	m_TexturePath.assign(sourcePath + header->sourcePathLength, header->texturePathLength);
+	m_VertexCount = static_cast<size_t>(header->vertexCount);
+	m_IndexCount = static_cast<size_t>(header->indexCount);
+	m_IndexSize = header->indexSize;
+	m_LodCount = header->lodCount;
+	const uint8_t* data = m_File.GetData() + dataOffset;
+	m_Vertices = reinterpret_cast<const Vertex*>(data);
+	data += m_VertexCount * sizeof(Vertex);
+	m_Lods = reinterpret_cast<const MeshLod*>(data);
+	data += m_LodCount * sizeof(MeshLod);
+	m_Indices = data;
+	return true;
+}
+
+void MeshCache::Write(const Key& key, const std::vector<Vertex>& vertices,
+					  const std::vector<MeshLod>& lods, const void* indices, size_t indexCount,
+					  size_t indexSize, const std::string& texturePath)
+{
+	Header header{};
+	std::memcpy(header.magic, "MESH", 4);
+	header.version = s_Version;
+	header.sourceTime = GetSourceTime(key.filename);
+	header.importFlags = key.importFlags;
+	header.scale = key.scale;
+	header.vertexCount = vertices.size();
+	header.indexCount = indexCount;
+	header.indexSize = static_cast<uint32_t>(indexSize);
+	header.lodCount = static_cast<uint32_t>(lods.size());
+	header.sourcePathLength = static_cast<uint32_t>(key.filename.size());
+	header.texturePathLength = static_cast<uint32_t>(texturePath.size());
+
+	std::error_code error;
+	std::filesystem::create_directories(s_CacheDirectory, error);
+
+	// Write next to the final entry and rename, so a crash never leaves a truncated cache behind
+	std::string cachePath = GetCachePath(key);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream fs(tempPath, std::ios::binary | std::ios::trunc);
+		if (!fs) return;
+		fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fs.write(key.filename.data(), key.filename.size());
+		fs.write(texturePath.data(), texturePath.size());
+		size_t padding = GetDataOffset(header) - sizeof(header) - key.filename.size() -
+						 texturePath.size();
+		const char zeros[16]{};
+		fs.write(zeros, padding);
+		fs.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+		fs.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshLod));
+		fs.write(reinterpret_cast<const char*>(indices), indexCount * indexSize);
+		if (!fs) return;
+	}
+	std::filesystem::rename(tempPath, cachePath, error);
+}
+
+std::string MeshCache::GetCachePath(const Key& key)
+{
+	// Every key field is part of the name, so the same mesh loaded with other flags or at another
+	// scale gets an entry of its own instead of replacing the previous one
+	uint32_t scaleBits;
+	std::memcpy(&scaleBits, &key.scale, sizeof(scaleBits));
+	std::ostringstream sstream;
+	sstream << s_CacheDirectory << "/" << std::hex << std::setfill('0')
+			<< std::hash<std::string>{}(key.filename) << "_" << std::setw(8) << key.importFlags
+			<< "_" << std::setw(8) << scaleBits << ".mesh";
+	return sstream.str();
+}
+
+int64_t MeshCache::GetSourceTime(const std::string& filename)
+{
+	std::error_code error;
+	auto time = std::filesystem::last_write_time(filename, error);
+	if (error) return 0;
+	return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+size_t MeshCache::GetDataOffset(const Header& header)
+{
+	size_t offset = sizeof(Header) + header.sourcePathLength + header.texturePathLength;
+	return (offset + 15) & ~static_cast<size_t>(15);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Entity.h"
+#include "MappedFile.h"
+
+// Binary cache of the final, normalized vertex and index arrays produced by Entity::Load. Entries
+// are keyed by source path, source modification time, import flags and scale; any mismatch or a
+// version bump turns the lookup into a miss and the mesh is imported again. The vertex array is
+// followed by the level of detail table and the indices of all levels, stored with the size they
+// are drawn with, 2 or 4 bytes.
+class MeshCache
+{
+public:
+	struct Key
+	{
+		std::string filename;
+		uint32_t importFlags;
+		float scale;
+	};
+
+public:
+	MeshCache() = default;
+
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	bool Open(const Key& key);
+	static void Write(const Key& key, const std::vector<Vertex>& vertices,
+					  const std::vector<MeshLod>& lods, const void* indices, size_t indexCount,
+					  size_t indexSize, const std::string& texturePath);
+
+	const Vertex* GetVertices() const
+	{
+		return m_Vertices;
+	}
+	size_t GetVertexCount() const
+	{
+		return m_VertexCount;
+	}
+	const MeshLod* GetLods() const
+	{
+		return m_Lods;
+	}
+	size_t GetLodCount() const
+	{
+		return m_LodCount;
+	}
+	const void* GetIndices() const
+	{
+		return m_Indices;
+	}
+	size_t GetIndexCount() const
+	{
+		return m_IndexCount;
+	}
+	size_t GetIndexSize() const
+	{
+		return m_IndexSize;
+	}
+	const std::string& GetTexturePath() const
+	{
+		return m_TexturePath;
+	}
+
+private:
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		int64_t sourceTime;
+		uint32_t importFlags;
+		float scale;
+		uint64_t vertexCount;
+		uint64_t indexCount;
+		uint32_t indexSize;
+		uint32_t lodCount;
+		uint32_t sourcePathLength;
+		uint32_t texturePathLength;
+	};
+	static constexpr uint32_t s_Version = 3;
+
+	static std::string GetCachePath(const Key& key);
+	static int64_t GetSourceTime(const std::string& filename);
+	static size_t GetDataOffset(const Header& header);
+
+private:
+	MappedFile m_File{};
+	const Vertex* m_Vertices = nullptr;
+	size_t m_VertexCount = 0;
+	const MeshLod* m_Lods = nullptr;
+	size_t m_LodCount = 0;
+	const void* m_Indices = nullptr;
+	size_t m_IndexCount = 0;
+	size_t m_IndexSize = 0;
+	std::string m_TexturePath{};
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Entity.h"
+
+// Offline passes over triangle lists, run when a mesh is imported before it is written to the
+// mesh cache. Optimize builds the level of detail chain and applies the remaining passes in the
+// usual order: vertex cache, overdraw, vertex fetch.
+class MeshOptimizer
+{
+private:
+	MeshOptimizer() = default;
+
+public:
+	MeshOptimizer(const MeshOptimizer&) = delete;
+	MeshOptimizer& operator=(const MeshOptimizer&) = delete;
+
+	// Replaces indices with lodCount levels stored back to back, finest first, and returns their
+	// ranges. Levels stop early once simplification no longer removes a meaningful share.
+	static std::vector<MeshLod> Optimize(std::vector<Vertex>& vertices,
+										 std::vector<uint32_t>& indices, size_t lodCount = 1);
+
+	// Quadric error edge collapse down to targetIndexCount indices. Vertices only collapse onto
+	// their neighbours, so the result still indexes the same vertex array; seams and open borders
+	// are kept in place. Returns the largest surface deviation introduced, in mesh units.
+	static float Simplify(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+						  size_t targetIndexCount);
+
+	// Forsyth's linear-speed vertex cache optimization
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+	// Splits the triangle list at cache-cold triangles and sorts the resulting clusters so that
+	// outward facing ones are drawn first, which cuts overdraw from most view directions
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices,
+								 const std::vector<Vertex>& vertices);
+	// Renumbers vertices in first use order and drops unreferenced ones
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	// Average cache miss ratio: transformed vertices per triangle with a FIFO post-transform cache
+	static float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount,
+							 size_t cacheSize = s_CacheSize);
+
+private:
+	static constexpr size_t s_CacheSize = 32;
+};
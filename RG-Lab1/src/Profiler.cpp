@@ -0,0 +1,134 @@
+#include "Profiler.h"
+
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+
+Profiler::Frame Profiler::s_Frames[Profiler::s_FrameLatency];
+uint64_t Profiler::s_FrameIndex = 0;
+bool Profiler::s_InFrame = false;
+bool Profiler::s_InScope = false;
+std::vector<Profiler::ScopeResult> Profiler::s_Results;
+float Profiler::s_ResultsFrameMs = 0.f;
+std::ofstream Profiler::s_Csv;
+
+static float GetMilliseconds(std::chrono::high_resolution_clock::duration duration)
+{
+	return std::chrono::duration<float, std::chrono::milliseconds::period>(duration).count();
+}
+
+void Profiler::BeginFrame()
+{
+	if (s_InFrame) EndFrame();
+
+	s_FrameIndex++;
+	Frame& frame = s_Frames[s_FrameIndex % s_FrameLatency];
+	if (frame.pending) Resolve(frame);
+
+	frame.index = s_FrameIndex;
+	frame.pending = true;
+	frame.scopes.clear();
+	frame.start = Clock::now();
+	s_InFrame = true;
+}
+
+void Profiler::EndFrame()
+{
+	if (!s_InFrame) return;
+	if (s_InScope) EndScope();
+	s_Frames[s_FrameIndex % s_FrameLatency].end = Clock::now();
+	s_InFrame = false;
+}
+
+void Profiler::BeginScope(const char* name)
+{
+	assert(!s_InScope && "Profiler scopes cannot nest");
+	if (!s_InFrame || s_InScope) return;
+
+	Frame& frame = s_Frames[s_FrameIndex % s_FrameLatency];
+	size_t queryIndex = frame.scopes.size();
+	if (queryIndex == frame.queries.size())
+	{
+		uint32_t query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	if (GLAD_GL_VERSION_4_3) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	glBeginQuery(GL_TIME_ELAPSED, frame.queries[queryIndex]);
+	frame.scopes.push_back({name, frame.queries[queryIndex], Clock::now(), {}});
+	s_InScope = true;
+}
+
+void Profiler::EndScope()
+{
+	if (!s_InScope) return;
+
+	Frame& frame = s_Frames[s_FrameIndex % s_FrameLatency];
+	frame.scopes.back().cpuEnd = Clock::now();
+	glEndQuery(GL_TIME_ELAPSED);
+	if (GLAD_GL_VERSION_4_3) glPopDebugGroup();
+	s_InScope = false;
+}
+
+std::string Profiler::FormatResults()
+{
+	std::ostringstream sstream;
+	sstream << std::fixed << std::setprecision(2) << "frame " << s_ResultsFrameMs << " ms";
+	for (const auto& result : s_Results)
+	{
+		sstream << " | " << result.name << " " << result.cpuMs << "/";
+		if (result.gpuMs >= 0.f) { sstream << result.gpuMs; }
+		else
+		{
+			sstream << "-";
+		}
+	}
+	return sstream.str();
+}
+
+bool Profiler::StartCsv(const std::string& path)
+{
+	StopCsv();
+	s_Csv.open(path, std::ios::trunc);
+	if (!s_Csv) return false;
+	s_Csv << "frame,scope,cpu_ms,gpu_ms\n";
+	return true;
+}
+
+void Profiler::StopCsv()
+{
+	if (s_Csv.is_open()) s_Csv.close();
+}
+
+void Profiler::Resolve(Frame& frame)
+{
+	frame.pending = false;
+	s_Results.clear();
+	s_ResultsFrameMs = GetMilliseconds(frame.end - frame.start);
+	for (const auto& scope : frame.scopes)
+	{
+		// Results are normally in by now; rather report a gap than wait for the GPU
+		int available = 0;
+		glGetQueryObjectiv(scope.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		float gpuMs = -1.f;
+		if (available)
+		{
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(scope.query, GL_QUERY_RESULT, &elapsed);
+			gpuMs = elapsed / 1e6f;
+		}
+		s_Results.push_back({scope.name, GetMilliseconds(scope.cpuEnd - scope.cpuStart), gpuMs});
+	}
+
+	if (s_Csv.is_open())
+	{
+		s_Csv << frame.index << ",frame," << s_ResultsFrameMs << ",\n";
+		for (const auto& result : s_Results)
+		{
+			s_Csv << frame.index << "," << result.name << "," << result.cpuMs << ",";
+			if (result.gpuMs >= 0.f) s_Csv << result.gpuMs;
+			s_Csv << "\n";
+		}
+	}
+}
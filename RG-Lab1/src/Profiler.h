@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+// CPU and GPU timings of named scopes within a frame. GPU times come from GL_TIME_ELAPSED queries
+// that are read back s_FrameLatency frames later, when they are ready, so the profiler never
+// stalls the pipeline. Those queries cannot nest, and neither can scopes. Every scope is also a
+// KHR_debug group so it shows up in frame debuggers. Only call it from the GL thread.
+class Profiler
+{
+public:
+	struct ScopeResult
+	{
+		std::string name;
+		float cpuMs;
+		// Negative when the query result was not available in time
+		float gpuMs;
+	};
+
+private:
+	Profiler() = default;
+
+public:
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	static void BeginFrame();
+	static void EndFrame();
+
+	static void BeginScope(const char* name);
+	static void EndScope();
+
+	// Scopes of the newest frame whose GPU results have been read back
+	static const std::vector<ScopeResult>& GetResults()
+	{
+		return s_Results;
+	}
+	static float GetFrameMs()
+	{
+		return s_ResultsFrameMs;
+	}
+	// One line summary of GetResults, as "name cpu/gpu ms" per scope
+	static std::string FormatResults();
+
+	// Streams every resolved frame to a CSV file with one row per scope
+	static bool StartCsv(const std::string& path);
+	static void StopCsv();
+	static bool IsRecordingCsv()
+	{
+		return s_Csv.is_open();
+	}
+
+private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	struct Scope
+	{
+		std::string name;
+		uint32_t query;
+		Clock::time_point cpuStart;
+		Clock::time_point cpuEnd;
+	};
+
+	struct Frame
+	{
+		uint64_t index = 0;
+		bool pending = false;
+		Clock::time_point start;
+		Clock::time_point end;
+		std::vector<Scope> scopes;
+		// Query objects owned by this frame slot, reused every time it comes around
+		std::vector<uint32_t> queries;
+	};
+
+	static void Resolve(Frame& frame);
+
+private:
+	static constexpr size_t s_FrameLatency = 2;
+
+	static Frame s_Frames[s_FrameLatency];
+	static uint64_t s_FrameIndex;
+	static bool s_InFrame;
+	static bool s_InScope;
+
+	static std::vector<ScopeResult> s_Results;
+	static float s_ResultsFrameMs;
+	static std::ofstream s_Csv;
+};
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+	ProfileScope(const char* name)
+	{
+		Profiler::BeginScope(name);
+	}
+	~ProfileScope()
+	{
+		Profiler::EndScope();
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "glad/glad.h"
+
+// On-disk cache of linked program binaries. Entries are named after the shader files and keyed by
+// a hash of their source and of the driver's vendor, renderer and version strings; a mismatch, a
+// version bump or a binary the driver rejects turns the lookup into a miss and the program is
+// compiled from source again.
+class ProgramCache
+{
+private:
+	ProgramCache() = default;
+
+public:
+	ProgramCache(const ProgramCache&) = delete;
+	ProgramCache& operator=(const ProgramCache&) = delete;
+
+	// Returns a linked program, or 0 when there is no valid entry for name and source
+	static uint32_t Load(const std::string& name, const std::string& source);
+	// Must be called before linking for the driver to keep the binary retrievable
+	static void PrepareForStore(uint32_t program);
+	static void Store(const std::string& name, const std::string& source, uint32_t program);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint64_t driverHash;
+		uint32_t binaryFormat;
+		uint32_t binarySize;
+	};
+	static constexpr uint32_t s_Version = 1;
+
+	static bool IsSupported();
+	static std::string GetCachePath(const std::string& name);
+	static uint64_t GetDriverHash();
+};
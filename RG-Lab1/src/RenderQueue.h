@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "TextureCache.h"
+
+// Passes are drawn in this order. The sky goes after opaque geometry so that most of it fails the
+// depth test early, and transparent geometry blends over both.
+enum class RenderPass : uint8_t
+{
+	Opaque,
+	Sky,
+	Transparent
+};
+
+// One draw: either an indexed mesh described by the fields below, or a custom draw callback for
+// geometry that issues its own calls (curves, particles). The queue binds the shader, textures
+// and vertex array; the callback sets its own uniforms.
+struct DrawCommand
+{
+	// Profiler scope and debug group label
+	const char* name = "draw";
+	RenderPass pass = RenderPass::Opaque;
+	Shader* shader = nullptr;
+	const Texture* textures[2]{};
+	uint32_t vertexArray = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	GLsizei indexCount = 0;
+	size_t indexOffset = 0;
+	glm::mat4 model{1.f};
+	glm::vec3 positionScale{1.f};
+	glm::vec3 positionOffset{0.f};
+	// Distance from the camera, drawn front to back except in the transparent pass
+	float depth = 0.f;
+	std::function<void(Shader&)> draw{};
+};
+
+struct RenderStatistics
+{
+	uint32_t drawCalls = 0;
+	uint32_t programChanges = 0;
+	uint32_t textureChanges = 0;
+	uint32_t vertexArrayChanges = 0;
+};
+
+// Collects the draws of a frame and issues them sorted by a key of pass, program, texture and
+// depth, so state is only changed between commands that actually differ.
+class RenderQueue
+{
+public:
+	RenderQueue() = default;
+
+	RenderQueue(const RenderQueue&) = delete;
+	RenderQueue& operator=(const RenderQueue&) = delete;
+
+	void Submit(DrawCommand command);
+	void Flush();
+
+	// Counters of the last Flush
+	const RenderStatistics& GetStatistics() const
+	{
+		return m_Statistics;
+	}
+	void PrintStatistics() const;
+
+private:
+	static uint64_t MakeKey(const DrawCommand& command);
+
+private:
+	std::vector<DrawCommand> m_Commands{};
+	std::vector<std::pair<uint64_t, uint32_t>> m_Keys{};
+	RenderStatistics m_Statistics{};
+};
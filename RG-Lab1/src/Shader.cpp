@@ -4,28 +4,53 @@
 #include <iostream>
 #include <sstream>
 
+#include "ProgramCache.h"
+
 Shader::~Shader()
+{
+	Release();
+}
+
+void Shader::Release()
 {
 	glDeleteProgram(m_ID);
+	m_ID = 0;
+	m_UniformLocations.clear();
 }
 
 void Shader::Load(const std::string& vertexPath, const std::string& fragmentPath)
 {
-	int vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	std::string vertexShaderSource = ReadFile(vertexPath);
+	std::string fragmentShaderSource = ReadFile(fragmentPath);
+
+	std::string cacheName = vertexPath + "\n" + fragmentPath;
+	std::string cacheSource = vertexShaderSource + '\0' + fragmentShaderSource;
+	m_ID = ProgramCache::Load(cacheName, cacheSource);
+	if (!m_ID)
+	{
+		Compile(vertexShaderSource, fragmentShaderSource);
+		ProgramCache::Store(cacheName, cacheSource, m_ID);
+	}
+
+	ReflectUniforms();
+}
+
+void Shader::Compile(const std::string& vertexShaderSource, const std::string& fragmentShaderSource)
+{
+	int vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	const char* c = vertexShaderSource.c_str();
 	glShaderSource(vertexShader, 1, &c, NULL);
 	glCompileShader(vertexShader);
 	CheckCompileErrors(vertexShader, "VERTEX");
 
 	int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	std::string fragmentShaderSource = ReadFile(fragmentPath);
 	c = fragmentShaderSource.c_str();
 	glShaderSource(fragmentShader, 1, &c, NULL);
 	glCompileShader(fragmentShader);
 	CheckCompileErrors(fragmentShader, "FRAGMENT");
 
 	m_ID = glCreateProgram();
+	ProgramCache::PrepareForStore(m_ID);
 	glAttachShader(m_ID, vertexShader);
 	glAttachShader(m_ID, fragmentShader);
 	glLinkProgram(m_ID);
@@ -35,6 +60,30 @@ void Shader::Load(const std::string& vertexPath, const std::string& fragmentPath
 	glDeleteShader(fragmentShader);
 }
 
+void Shader::ReflectUniforms()
+{
+	m_UniformLocations.clear();
+	GLint uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(m_ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::string name(maxNameLength, '\0');
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_ID, i, maxNameLength, &length, &size, &type, name.data());
+		std::string uniformName = name.substr(0, length);
+		// Members of uniform blocks have no location
+		GLint location = glGetUniformLocation(m_ID, uniformName.c_str());
+		if (location < 0) continue;
+		m_UniformLocations[uniformName] = location;
+		// Arrays are reported as "name[0]" but are set through their plain name as well
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			m_UniformLocations[uniformName.substr(0, uniformName.size() - 3)] = location;
+	}
+}
+
 std::string Shader::ReadFile(const std::string& file)
 {
 	std::ostringstream sstream;
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -18,6 +19,8 @@ public:
 		return m_ID;
 	}
 	void Load(const std::string& vertexPath, const std::string& fragmentPath);
+	// Deletes the program ahead of the destructor, for owners that outlive the context
+	void Release();
 	void Use()
 	{
 		assert(m_ID);
@@ -25,30 +28,39 @@ public:
 	}
 	void SetBool(const std::string& name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(m_ID, name.c_str()), (int)value);
+		glUniform1i(GetUniformLocation(name), (int)value);
 	}
 	void SetInt(const std::string& name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(m_ID, name.c_str()), value);
+		glUniform1i(GetUniformLocation(name), value);
 	}
 	void SetFloat(const std::string& name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(m_ID, name.c_str()), value);
+		glUniform1f(GetUniformLocation(name), value);
 	}
 	void SetVec3f(const std::string& name, const glm::vec3 value)
 	{
-		glUniform3fv(glGetUniformLocation(m_ID, name.c_str()), 1, glm::value_ptr(value));
+		glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value));
 	}
 	void SetMat4f(const std::string& name, const glm::mat4 value)
 	{
-		glUniformMatrix4fv(glGetUniformLocation(m_ID, name.c_str()), 1, GL_FALSE,
-						   glm::value_ptr(value));
+		glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 	}
 
 private:
+	// Unknown names map to -1, which glUniform* silently ignores like it does for unused uniforms
+	GLint GetUniformLocation(const std::string& name) const
+	{
+		auto it = m_UniformLocations.find(name);
+		return it != m_UniformLocations.end() ? it->second : -1;
+	}
+	void Compile(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+	void ReflectUniforms();
 	std::string ReadFile(const std::string& file);
 	void CheckCompileErrors(unsigned int shader, std::string type);
 
 private:
 	uint32_t m_ID{};
+	// Locations of the default block uniforms, queried once after linking
+	std::unordered_map<std::string, GLint> m_UniformLocations{};
 };
@@ -0,0 +1,342 @@
+#include "StaticBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+
+#include "Entity.h"
+
+StaticBatch::~StaticBatch()
+{
+	Release();
+}
+
+void StaticBatch::Release()
+{
+	glDeleteVertexArrays(1, &m_VertexArray);
+	glDeleteBuffers(1, &m_VertexBuffer);
+	glDeleteBuffers(1, &m_IndexBuffer);
+	glDeleteBuffers(1, &m_DrawIDBuffer);
+	glDeleteBuffers(1, &m_DrawDataBuffer);
+	glDeleteBuffers(1, &m_IndirectBuffer);
+	for (const auto& array : m_TextureArrays)
+		glDeleteTextures(1, &array.id);
+
+	m_VertexArray = m_VertexBuffer = m_IndexBuffer = 0;
+	m_DrawIDBuffer = m_DrawDataBuffer = m_IndirectBuffer = 0;
+	m_VertexCount = m_VertexCapacity = 0;
+	m_IndexCount = m_IndexCapacity = 0;
+	m_DrawIDCapacity = 0;
+	m_TextureArrays.clear();
+	m_Layers.clear();
+	m_LayerIndices.clear();
+	m_DrawData.clear();
+	m_Commands.clear();
+	m_LastDrawCount = m_LastCallCount = 0;
+}
+
+BatchMesh StaticBatch::AddMesh(const QuantizedVertex* vertices, size_t vertexCount,
+							   const void* indices, size_t indexCount, size_t indexSize)
+{
+	if (!m_VertexArray) glGenVertexArrays(1, &m_VertexArray);
+	bool grown = Reserve(m_VertexBuffer, m_VertexCapacity, m_VertexCount,
+						 m_VertexCount + vertexCount, sizeof(QuantizedVertex));
+	grown |= Reserve(m_IndexBuffer, m_IndexCapacity, m_IndexCount, m_IndexCount + indexCount,
+					 sizeof(uint32_t));
+	if (grown) SetupVertexArray();
+
+	BatchMesh mesh{static_cast<int32_t>(m_VertexCount), static_cast<uint32_t>(m_IndexCount)};
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_VertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, m_VertexCount * sizeof(QuantizedVertex),
+					vertexCount * sizeof(QuantizedVertex), vertices);
+
+	// The arena has one index type, indices stay relative to their mesh through the base vertex
+	std::vector<uint32_t> wideIndices;
+	if (indexSize == sizeof(uint16_t))
+	{
+		const uint16_t* shortIndices = static_cast<const uint16_t*>(indices);
+		wideIndices.assign(shortIndices, shortIndices + indexCount);
+		indices = wideIndices.data();
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_IndexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, m_IndexCount * sizeof(uint32_t),
+					indexCount * sizeof(uint32_t), indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_VertexCount += vertexCount;
+	m_IndexCount += indexCount;
+	return mesh;
+}
+
+int32_t StaticBatch::AddTexture(const std::shared_ptr<Texture>& texture)
+{
+	if (!texture) return -1;
+	bool srgb = texture->GetFormat() == TextureFormat::SRGB8Alpha8;
+	std::string key = texture->GetName() + (srgb ? "|srgb" : "|rgba");
+	auto it = m_LayerIndices.find(key);
+	if (it != m_LayerIndices.end()) return it->second;
+
+	int32_t handle = static_cast<int32_t>(m_Layers.size());
+	m_Layers.push_back({texture});
+	m_LayerIndices[key] = handle;
+	return handle;
+}
+
+void StaticBatch::Submit(const BatchMesh& mesh, uint32_t firstIndex, uint32_t indexCount,
+						 const BatchDrawData& data, int32_t texture, int32_t normalTexture)
+{
+	FillLayers();
+
+	uint32_t drawIndex = static_cast<uint32_t>(m_Commands.size());
+	m_Commands.push_back(
+		{indexCount, 1, mesh.firstIndex + firstIndex, mesh.baseVertex, drawIndex});
+	BatchDrawData& draw = m_DrawData.emplace_back(data);
+	const Layer none{};
+	const Layer& textureLayer = texture >= 0 ? m_Layers[texture] : none;
+	const Layer& normalLayer = normalTexture >= 0 ? m_Layers[normalTexture] : none;
+	draw.textureArray = textureLayer.array;
+	draw.textureLayer = textureLayer.layer;
+	draw.normalArray = normalLayer.array;
+	draw.normalLayer = normalLayer.layer;
+}
+
+void StaticBatch::Draw()
+{
+	m_LastDrawCount = m_Commands.size();
+	m_LastCallCount = 0;
+	if (m_Commands.empty()) return;
+
+	if (m_Commands.size() > m_DrawIDCapacity)
+	{
+		m_DrawIDCapacity = std::max(m_Commands.size(), m_DrawIDCapacity * 2);
+		std::vector<uint32_t> drawIDs(m_DrawIDCapacity);
+		std::iota(drawIDs.begin(), drawIDs.end(), 0);
+		if (!m_DrawIDBuffer) glGenBuffers(1, &m_DrawIDBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_DrawIDBuffer);
+		glBufferData(GL_ARRAY_BUFFER, drawIDs.size() * sizeof(uint32_t), drawIDs.data(),
+					 GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		SetupVertexArray();
+	}
+
+	// Both buffers are orphaned every frame so the driver never waits on the previous frame
+	if (!m_DrawDataBuffer) glGenBuffers(1, &m_DrawDataBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_DrawDataBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_DrawData.size() * sizeof(BatchDrawData),
+				 m_DrawData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, s_BatchDrawBinding, m_DrawDataBuffer);
+
+	// Commands are grouped by the arrays they sample, their base instance still finds their data
+	auto getArrays = [this](const DrawElementsCommand& command) {
+		const BatchDrawData& data = m_DrawData[command.baseInstance];
+		return std::make_pair(data.textureArray, data.normalArray);
+	};
+	std::stable_sort(m_Commands.begin(), m_Commands.end(),
+					 [&getArrays](const DrawElementsCommand& a, const DrawElementsCommand& b) {
+						 return getArrays(a) < getArrays(b);
+					 });
+
+	if (!m_IndirectBuffer) glGenBuffers(1, &m_IndirectBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_Commands.size() * sizeof(DrawElementsCommand),
+				 m_Commands.data(), GL_STREAM_DRAW);
+
+	glBindVertexArray(m_VertexArray);
+	for (size_t first = 0; first < m_Commands.size();)
+	{
+		auto arrays = getArrays(m_Commands[first]);
+		size_t last = first + 1;
+		while (last < m_Commands.size() && getArrays(m_Commands[last]) == arrays)
+			last++;
+
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY,
+					  arrays.second >= 0 ? m_TextureArrays[arrays.second].id : 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY,
+					  arrays.first >= 0 ? m_TextureArrays[arrays.first].id : 0);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+									(void*)(first * sizeof(DrawElementsCommand)),
+									static_cast<GLsizei>(last - first), 0);
+		m_LastCallCount++;
+		first = last;
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	m_Commands.clear();
+	m_DrawData.clear();
+}
+
+void StaticBatch::PrintStatistics() const
+{
+	std::cout << "Static batch: " << m_LastDrawCount << " draws in " << m_LastCallCount
+			  << " calls, " << m_VertexCount << " vertices, " << m_IndexCount << " indices"
+			  << std::endl;
+	size_t layerCount = 0;
+	for (const auto& array : m_TextureArrays)
+		layerCount += array.layerCount;
+	std::cout << "  " << layerCount << " texture layers in " << m_TextureArrays.size()
+			  << " arrays, " << GetTextureMemory() / 1024 << " KiB" << std::endl;
+	for (const auto& array : m_TextureArrays)
+	{
+		std::cout << "  " << array.width << "x" << array.height << ": " << array.layerCount
+				  << " of " << array.layerCapacity << " layers, " << array.levels << " levels"
+				  << std::endl;
+	}
+}
+
+bool StaticBatch::Reserve(uint32_t& buffer, size_t& capacity, size_t count, size_t requiredCount,
+						  size_t elementSize)
+{
+	if (buffer && requiredCount <= capacity) return false;
+
+	size_t newCapacity = std::max(requiredCount, capacity * 2);
+	uint32_t newBuffer;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+	if (buffer && count)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, count * elementSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	buffer = newBuffer;
+	capacity = newCapacity;
+	return true;
+}
+
+void StaticBatch::SetupVertexArray()
+{
+	glBindVertexArray(m_VertexArray);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	GLsizei stride = sizeof(QuantizedVertex);
+	// position attribute
+	glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+						  (void*)offsetof(QuantizedVertex, pos));
+	glEnableVertexAttribArray(0);
+	// normal attribute
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+						  (void*)offsetof(QuantizedVertex, norm));
+	glEnableVertexAttribArray(1);
+	// texture coord attribute
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+						  (void*)offsetof(QuantizedVertex, texCoord));
+	glEnableVertexAttribArray(2);
+
+	// draw id attribute, advanced once per instance and offset by each command's base instance
+	if (m_DrawIDBuffer)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_DrawIDBuffer);
+		glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+		glVertexAttribDivisor(3, 1);
+		glEnableVertexAttribArray(3);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StaticBatch::FillLayers()
+{
+	bool copied = false;
+	for (auto& layer : m_Layers)
+	{
+		if (!layer.texture || !layer.texture->GetID()) continue;
+		const Texture& texture = *layer.texture;
+		layer.array = FindArray(texture);
+		TextureArray& array = m_TextureArrays[layer.array];
+		if (array.layerCount == array.layerCapacity) GrowArray(array);
+		layer.layer = array.layerCount++;
+
+		// Sizes and formats match, so every level is copied as is, without rescaling
+		for (GLint level = 0; level < array.levels; level++)
+		{
+			glCopyImageSubData(texture.GetID(), GL_TEXTURE_2D, level, 0, 0, 0, array.id,
+							   GL_TEXTURE_2D_ARRAY, level, 0, 0, layer.layer,
+							   std::max(array.width >> level, 1),
+							   std::max(array.height >> level, 1), 1);
+		}
+		layer.texture.reset();
+		copied = true;
+	}
+	// Sources nobody else draws with can go now that the arrays hold their pixels
+	if (copied) TextureCache::ReleaseUnused();
+}
+
+int32_t StaticBatch::FindArray(const Texture& texture)
+{
+	GLenum internalFormat =
+		texture.GetFormat() == TextureFormat::SRGB8Alpha8 ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	for (size_t i = 0; i < m_TextureArrays.size(); i++)
+	{
+		const TextureArray& array = m_TextureArrays[i];
+		if (array.width == texture.GetWidth() && array.height == texture.GetHeight() &&
+			array.internalFormat == internalFormat)
+			return static_cast<int32_t>(i);
+	}
+
+	TextureArray array;
+	array.internalFormat = internalFormat;
+	array.width = texture.GetWidth();
+	array.height = texture.GetHeight();
+	// A full chain down to 1x1, as glGenerateMipmap builds it for the source
+	array.levels = 1;
+	while (std::max(array.width, array.height) >> array.levels)
+		array.levels++;
+	m_TextureArrays.push_back(array);
+	return static_cast<int32_t>(m_TextureArrays.size() - 1);
+}
+
+void StaticBatch::GrowArray(TextureArray& array)
+{
+	// Texture storage is immutable, so the layers filled so far are copied into a larger array
+	GLsizei capacity = std::max(array.layerCapacity * 2, 1);
+	uint32_t id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, array.levels, array.internalFormat, array.width,
+				   array.height, capacity);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if (array.layerCount)
+	{
+		for (GLint level = 0; level < array.levels; level++)
+		{
+			glCopyImageSubData(array.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, id,
+							   GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+							   std::max(array.width >> level, 1),
+							   std::max(array.height >> level, 1), array.layerCount);
+		}
+	}
+	glDeleteTextures(1, &array.id);
+	array.id = id;
+	array.layerCapacity = capacity;
+}
+
+size_t StaticBatch::GetTextureMemory() const
+{
+	size_t size = 0;
+	for (const auto& array : m_TextureArrays)
+	{
+		for (GLsizei level = 0; level < array.levels; level++)
+		{
+			size += static_cast<size_t>(std::max(array.width >> level, 1)) *
+					std::max(array.height >> level, 1) * 4 * array.layerCapacity;
+		}
+	}
+	return size;
+}
@@ -0,0 +1,143 @@
+#include "TextureCache.h"
+
+#include <cassert>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "AssetLoader.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+std::unordered_map<std::string, std::shared_ptr<Texture>> TextureCache::s_Textures;
+
+Texture::Texture(const std::string& name, TextureFormat format)
+	: m_Name(name)
+	, m_Format(format)
+{
+}
+
+Texture::~Texture()
+{
+	if (m_ID) glDeleteTextures(1, &m_ID);
+}
+
+size_t Texture::GetMemorySize() const
+{
+	size_t size = static_cast<size_t>(m_Width) * m_Height * 4;
+	return m_Width * m_Height > 1 ? size * 4 / 3 : size;
+}
+
+void Texture::Upload(const unsigned char* pixels, int width, int height)
+{
+	m_Width = width;
+	m_Height = height;
+	GLint internalFormat = m_Format == TextureFormat::SRGB8Alpha8 ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+	glGenTextures(1, &m_ID);
+	glBindTexture(GL_TEXTURE_2D, m_ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+				 pixels);
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+std::shared_ptr<Texture> TextureCache::Load(const std::string& path, TextureFormat format,
+											AssetLoader* loader)
+{
+	if (path.empty() || !std::filesystem::exists(path)) return nullptr;
+
+	std::string key = path + (format == TextureFormat::SRGB8Alpha8 ? "|srgb" : "|rgba");
+	auto it = s_Textures.find(key);
+	if (it != s_Textures.end()) return it->second;
+
+	auto texture = std::make_shared<Texture>(path, format);
+	s_Textures[key] = texture;
+
+	if (loader)
+	{
+		// The handle is returned right away and gets its GL name once the upload runs
+		loader->Enqueue([texture, path]() -> AssetLoader::UploadTask {
+			int texWidth, texHeight, texChannels;
+			stbi_uc* pixels =
+				stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+			assert(pixels);
+			return [texture, pixels, texWidth, texHeight]() {
+				texture->Upload(pixels, texWidth, texHeight);
+				stbi_image_free(pixels);
+			};
+		});
+	}
+	else
+	{
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels =
+			stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		assert(pixels);
+		texture->Upload(pixels, texWidth, texHeight);
+		stbi_image_free(pixels);
+	}
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::GetSolidColor(glm::u8vec4 color)
+{
+	std::ostringstream sstream;
+	sstream << "color:" << std::hex << std::setfill('0');
+	for (int i = 0; i < 4; i++)
+		sstream << std::setw(2) << static_cast<int>(color[i]);
+	std::string key = sstream.str();
+
+	auto it = s_Textures.find(key);
+	if (it != s_Textures.end()) return it->second;
+
+	auto texture = std::make_shared<Texture>(key, TextureFormat::RGBA8);
+	texture->Upload(&color[0], 1, 1);
+	s_Textures[key] = texture;
+	return texture;
+}
+
+void TextureCache::ReleaseUnused()
+{
+	for (auto it = s_Textures.begin(); it != s_Textures.end();)
+	{
+		if (it->second.use_count() == 1) it = s_Textures.erase(it);
+		else
+			++it;
+	}
+}
+
+void TextureCache::Clear()
+{
+	for (auto& [key, texture] : s_Textures)
+	{
+		if (texture->m_ID) glDeleteTextures(1, &texture->m_ID);
+		texture->m_ID = 0;
+	}
+	s_Textures.clear();
+}
+
+size_t TextureCache::GetMemoryUsage()
+{
+	size_t size = 0;
+	for (const auto& [key, texture] : s_Textures)
+		size += texture->GetMemorySize();
+	return size;
+}
+
+void TextureCache::PrintStatistics()
+{
+	std::cout << "Texture cache: " << s_Textures.size() << " textures, "
+			  << GetMemoryUsage() / 1024 << " KiB" << std::endl;
+	for (const auto& [key, texture] : s_Textures)
+	{
+		std::cout << "  " << texture->GetName() << " " << texture->GetWidth() << "x"
+				  << texture->GetHeight() << ", " << texture->GetMemorySize() / 1024 << " KiB, "
+				  << texture.use_count() - 1 << " users" << std::endl;
+	}
+}
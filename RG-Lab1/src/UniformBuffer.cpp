@@ -0,0 +1,36 @@
+#include "UniformBuffer.h"
+
+#include <cassert>
+
+UniformBuffer::~UniformBuffer()
+{
+	Release();
+}
+
+void UniformBuffer::Release()
+{
+	glDeleteBuffers(1, &m_ID);
+	m_ID = 0;
+	m_Size = 0;
+}
+
+void UniformBuffer::Create(size_t size, GLuint binding)
+{
+	assert(!m_ID);
+	m_Size = size;
+	m_Binding = binding;
+	glGenBuffers(1, &m_ID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_ID);
+}
+
+void UniformBuffer::SetData(const void* data, size_t size)
+{
+	assert(m_ID && size <= m_Size);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ID);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, m_Binding, m_ID);
+}
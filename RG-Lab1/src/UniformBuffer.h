@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "glad/glad.h"
+
+// Binding points of the uniform blocks shared by all programs. They match the binding layout
+// qualifiers in src/shaders, so no program has to be set up individually.
+constexpr GLuint s_CameraBinding = 0;
+
+// std140 layout of the Camera block, updated once per frame
+struct CameraUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 cameraPos;
+	float padding;
+};
+
+class UniformBuffer
+{
+public:
+	UniformBuffer() = default;
+	~UniformBuffer();
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	void Create(size_t size, GLuint binding);
+	// Replaces the whole contents and binds the buffer to its binding point again
+	void SetData(const void* data, size_t size);
+	// Deletes the buffer ahead of the destructor, for owners that outlive the context
+	void Release();
+
+private:
+	uint32_t m_ID{};
+	size_t m_Size = 0;
+	GLuint m_Binding = 0;
+};
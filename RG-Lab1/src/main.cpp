@@ -1,9 +1,15 @@
 #include <chrono>
 
+#include "Benchmark.h"
 #include "Game.h"
+#include "Profiler.h"
 
-int main()
+int main(int argc, char** argv)
 {
+	BenchmarkSettings benchmarkSettings;
+	if (Benchmark::ParseArguments(argc, argv, benchmarkSettings))
+		return Benchmark::Run("Lab 1", benchmarkSettings);
+
 	Game::CreateGame("Lab 1", 2000, 1500);
 	auto lastFrameTime = std::chrono::high_resolution_clock::now();
 	while (Game::Get().IsRunning())
@@ -11,9 +17,11 @@ int main()
 		auto currentTime = std::chrono::high_resolution_clock::now();
 		auto timeStep = currentTime - lastFrameTime;
 		lastFrameTime = currentTime;
+		Profiler::BeginFrame();
 		Game::Get().Update(
 			std::chrono::duration<float, std::chrono::milliseconds::period>(timeStep).count());
 		Game::Get().Render();
+		Profiler::EndFrame();
 	}
 	return 0;
 }
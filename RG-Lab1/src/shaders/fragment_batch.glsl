@@ -1,14 +1,23 @@
-#version 460 core
+#version 450 core
 
 layout (location = 0) in vec2 fragTexCoord;
 layout (location = 1) in vec3 fragNorm;
 layout (location = 2) in vec3 fragWorldPos;
+layout (location = 3) flat in int fragTextureLayer;
+layout (location = 4) flat in int fragNormalLayer;
+layout (location = 5) flat in vec4 fragColor;
 
 out vec4 outColor;
 
-uniform vec3 cameraPos;
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+};
 
-uniform sampler2D tex;
+uniform sampler2DArray textures;
+uniform sampler2DArray normalTextures;
 
 vec3 computeDiffuse(vec3 diffuse, vec3 ambient, vec3 lightDir, vec3 normal)
 {
@@ -34,14 +43,24 @@ void main()
     lightDir = normalize(lightDir);
     float lightIntensity = 0.6;
 
+    vec3 normal = fragNorm;
+    if (fragNormalLayer >= 0)
+    {
+        vec4 normalMapColor = texture(normalTextures, vec3(fragTexCoord, fragNormalLayer));
+        normal = normalize(vec3(normalMapColor.r * 2.0 - 1.0, normalMapColor.b * 3, normalMapColor.g * 2.0 - 1.0));
+    }
+
     vec3 diffuse = {0.8, 0.8, 0.8};
     vec3 ambient = {0.4, 0.4, 0.4};
-    vec3 diffuseColor = computeDiffuse(diffuse, ambient, lightDir, fragNorm);
-    diffuseColor *= texture(tex, fragTexCoord).xyz;
+    vec3 diffuseColor = computeDiffuse(diffuse, ambient, lightDir, normal);
+    if (fragTextureLayer >= 0)
+        diffuseColor *= texture(textures, vec3(fragTexCoord, fragTextureLayer)).xyz;
+    else
+        diffuseColor *= fragColor.xyz;
 
     vec3 viewDir = normalize(cameraPos - fragWorldPos);
     vec3 specular = {0.05, 0.05, 0.05};
-    vec3 specularColor = computeSpecular(specular, viewDir, lightDir, fragNorm);
+    vec3 specularColor = computeSpecular(specular, viewDir, lightDir, normal);
 
     float gamma = 1. / 2.2;
     outColor = pow(vec4(lightIntensity * (diffuseColor + specularColor), 1.f), vec4(gamma));
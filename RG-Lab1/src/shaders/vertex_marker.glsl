@@ -1,12 +1,17 @@
-#version 460
+#version 450
 
 layout (location = 0) in vec3 pos;
 
 layout(location = 0) out vec3 fragWorldPos;
 
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -0,0 +1,73 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+AssetLoader::AssetLoader(uint32_t workerCount)
+{
+	// Keep one core for the render thread
+	workerCount = std::max(workerCount, 2u) - 1;
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&AssetLoader::WorkerLoop, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_LoadMutex);
+		m_Stopping = true;
+	}
+	m_LoadCondition.notify_all();
+	for (auto& worker : m_Workers)
+		worker.join();
+}
+
+void AssetLoader::Enqueue(LoadTask task)
+{
+	m_PendingCount++;
+	{
+		std::lock_guard<std::mutex> lock(m_LoadMutex);
+		m_LoadTasks.push_back(std::move(task));
+	}
+	m_LoadCondition.notify_one();
+}
+
+void AssetLoader::ProcessUploads(float budgetMs)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	while (true)
+	{
+		UploadTask task;
+		{
+			std::lock_guard<std::mutex> lock(m_UploadMutex);
+			if (m_UploadTasks.empty()) return;
+			task = std::move(m_UploadTasks.front());
+			m_UploadTasks.pop_front();
+		}
+		if (task) task();
+		m_PendingCount--;
+
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+		if (std::chrono::duration<float, std::chrono::milliseconds::period>(elapsed).count() >=
+			budgetMs)
+			return;
+	}
+}
+
+void AssetLoader::WorkerLoop()
+{
+	while (true)
+	{
+		LoadTask task;
+		{
+			std::unique_lock<std::mutex> lock(m_LoadMutex);
+			m_LoadCondition.wait(lock, [this] { return m_Stopping || !m_LoadTasks.empty(); });
+			if (m_Stopping) return;
+			task = std::move(m_LoadTasks.front());
+			m_LoadTasks.pop_front();
+		}
+		UploadTask upload = task();
+		std::lock_guard<std::mutex> lock(m_UploadMutex);
+		m_UploadTasks.push_back(std::move(upload));
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the CPU side of asset loading (file IO, Assimp, image decoding) on worker threads. Every
+// load task returns the GL work needed to finish it, which is queued and executed on the main
+// thread by ProcessUploads within a per-frame time budget.
+class AssetLoader
+{
+public:
+	using UploadTask = std::function<void()>;
+	using LoadTask = std::function<UploadTask()>;
+
+public:
+	AssetLoader(uint32_t workerCount = std::thread::hardware_concurrency());
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	void Enqueue(LoadTask task);
+	void ProcessUploads(float budgetMs);
+
+	bool IsIdle() const
+	{
+		return m_PendingCount == 0;
+	}
+
+private:
+	void WorkerLoop();
+
+private:
+	std::vector<std::thread> m_Workers;
+
+	std::mutex m_LoadMutex;
+	std::condition_variable m_LoadCondition;
+	std::deque<LoadTask> m_LoadTasks;
+	bool m_Stopping = false;
+
+	std::mutex m_UploadMutex;
+	std::deque<UploadTask> m_UploadTasks;
+
+	std::atomic<uint32_t> m_PendingCount{0};
+};
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <deque>
+#include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
+#include "MappedFile.h"
+#include "Spline.h"
+
+// Control points are either the built-in path or a recorded one mapped from a binary file:
+//   char magic[4] = "BSPL", uint32_t version, uint64_t pointCount, float xyz[pointCount][3]
+// Only a window of segments around the current one is sampled and framed, and it is extended
+// incrementally as the object moves, so arbitrarily long paths can be replayed.
 class BSplineCurve
 {
 public:
+	BSplineCurve();
+
+	bool Load(const std::string& filename);
+
 	void OnUpdate(float ms);
 	void Render();
 	void RenderControlPoints();
@@ -14,25 +28,55 @@ public:
 	glm::mat4 GetObjectModelMatrix();
 	glm::vec3 GetPosition();
 	glm::vec3 GetVelocity();
+	float GetDistance() const;
 
 private:
-	glm::vec3 GetCurvePoint(const glm::vec3& point1, const glm::vec3& point2,
-							const glm::vec3& point3, const glm::vec3& point4, float t);
-	glm::vec3 GetFirstDerivative(const glm::vec3& point1, const glm::vec3& point2,
-								 const glm::vec3& point3, const glm::vec3& point4, float t);
-	glm::vec3 GetSecondDerivative(const glm::vec3& point1, const glm::vec3& point2,
-								  const glm::vec3& point3, const glm::vec3& point4, float t);
+	struct BakedSegment
+	{
+		// m_SamplesPerSegment + 1 samples, their rotation minimizing frames and arc length from
+		// the start of the path. Frames map object space x, y, z onto binormal, normal and
+		// tangent.
+		std::vector<glm::vec3> samples;
+		std::vector<glm::quat> frames;
+		std::vector<float> distances;
+	};
+
+	void ResetWindow();
+	void AdvanceWindow();
+	void BakeSegment(size_t segment);
+	const BakedSegment& GetBakedSegment(size_t segment) const;
+	glm::quat GetFrame(size_t segment, float t) const;
+
+	glm::vec3 GetCurvePoint(size_t segment, float t) const;
+	glm::vec3 GetFirstDerivative(size_t segment, float t) const;
+	glm::vec3 GetSecondDerivative(size_t segment, float t) const;
 
 private:
+	using Curve = CubicBSpline;
+
+	struct PathHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t pointCount;
+	};
+	static constexpr uint32_t s_PathVersion = 1;
+
 	std::vector<glm::vec3> m_Points{{0, 0, 0},	{0, 10, 5},	 {10, 10, 10}, {10, 0, 15},
 									{0, 0, 20}, {0, 10, 25}, {10, 10, 30}, {10, 0, 35},
 									{0, 0, 40}, {0, 10, 45}, {10, 10, 50}, {10, 0, 55}};
-	const glm::mat4 m0{-1, 3, -3, 1, 3, -6, 0, 4, -3, 3, 3, 1, 1, 0, 0, 0};
-	const glm::mat4x3 m1{-1, 2, -1, 3, -4, 0, -3, 2, 1, 1, 0, 0};
-	const glm::mat4x2 m2{-1, 1, 3, -2, -3, 1, 1, 0};
+	MappedFile m_PathFile{};
+	const glm::vec3* m_ControlPoints = nullptr;
+	size_t m_PointCount = 0;
+	size_t m_SegmentCount = 0;
+
+	std::deque<BakedSegment> m_Window{};
+	size_t m_WindowStart = 0;
+	const size_t m_SegmentsBehind = 16;
+	const size_t m_SegmentsAhead = 64;
 
 	size_t m_CurrentPoint = 0;
 	float m_CurrentT = 0;
-	const float m_Step = 0.01f;
+	const size_t m_SamplesPerSegment = 100;
 	const float m_Velocity = 0.001f;
 };
@@ -1,34 +1,209 @@
 #include "Entity.h"
 
+#include <cassert>
+#include <cstddef>
 #include <fstream>
+#include <limits>
 
-#include "assimp/postprocess.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "AssetLoader.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
 
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 Entity::~Entity()
 {
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	Unload();
 }
 
+struct Entity::MeshData
+{
+	MeshCache cache;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint16_t> shortIndices;
+	const Vertex* vertexData = nullptr;
+	size_t vertexCount = 0;
+	const void* indexData = nullptr;
+	size_t indexCount = 0;
+	size_t indexSize = sizeof(uint32_t);
+	std::vector<MeshLod> lods;
+	std::string texturePath;
+	// Measured on the worker, reported from the GL thread once the entity has been uploaded
+	ImportStatistics statistics;
+
+	glm::vec3 boundsCenter{0.f};
+	float boundsRadius = 0.f;
+	float boundsInnerRadius = 0.f;
+
+	VertexFormat format = VertexFormat::Float;
+	std::vector<QuantizedVertex> quantizedVertices;
+	glm::vec3 positionScale{1.f};
+	glm::vec3 positionOffset{0.f};
+};
+
 void Entity::Load(const std::string& filename, float newScale, glm::u8vec4 color,
-				  const std::string& normalMap)
+				  const std::string& normalMap, VertexFormat format)
+{
+	m_Name = filename;
+	MeshData data;
+	Read(data, filename, newScale, format);
+	Upload(data, color, normalMap, nullptr);
+}
+
+void Entity::LoadAsync(AssetLoader& loader, const std::string& filename, float newScale,
+					   glm::u8vec4 color, const std::string& normalMap, VertexFormat format)
+{
+	m_Name = filename;
+	loader.Enqueue([this, &loader, filename, newScale, color, normalMap,
+					format]() -> AssetLoader::UploadTask {
+		auto data = std::make_shared<MeshData>();
+		Read(*data, filename, newScale, format);
+		return [this, &loader, data, color, normalMap]() {
+			Upload(*data, color, normalMap, &loader);
+		};
+	});
+}
+
+void Entity::Unload()
+{
+	if (VAO)
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		VAO = VBO = EBO = 0;
+	}
+	m_Lods.clear();
+	m_Lod = 0;
+	m_ImportStatistics = {};
+	m_BatchTexture = -1;
+	m_BatchNormalTexture = -1;
+
+	if (m_Texture || m_NormalTexture)
+	{
+		m_Texture.reset();
+		m_NormalTexture.reset();
+		TextureCache::ReleaseUnused();
+	}
+}
+
+void Entity::Read(MeshData& data, const std::string& filename, float newScale,
+				  VertexFormat format)
+{
+	MeshCache::Key key{filename, s_ImportFlags, newScale};
+	if (data.cache.Open(key))
+	{
+		data.texturePath = data.cache.GetTexturePath();
+		data.vertexData = data.cache.GetVertices();
+		data.vertexCount = data.cache.GetVertexCount();
+		data.indexData = data.cache.GetIndices();
+		data.indexCount = data.cache.GetIndexCount();
+		data.indexSize = data.cache.GetIndexSize();
+		data.lods.assign(data.cache.GetLods(), data.cache.GetLods() + data.cache.GetLodCount());
+	}
+	else
+	{
+		Import(filename, newScale, data.vertices, data.indices, data.texturePath);
+		Optimize(data);
+		MeshCache::Write(key, data.vertices, data.lods, data.indexData, data.indexCount,
+						 data.indexSize, data.texturePath);
+		data.vertexData = data.vertices.data();
+		data.vertexCount = data.vertices.size();
+	}
+
+	ComputeBounds(data);
+	data.format = format;
+	if (format == VertexFormat::Quantized) Quantize(data);
+}
+
+void Entity::Optimize(MeshData& data)
+{
+	data.statistics.optimized = true;
+	data.statistics.acmrBefore = MeshOptimizer::ComputeACMR(data.indices, data.vertices.size());
+	data.lods = MeshOptimizer::Optimize(data.vertices, data.indices, s_LodCount);
+	std::vector<uint32_t> finest(data.indices.begin(),
+								 data.indices.begin() + data.lods[0].indexCount);
+	data.statistics.acmrAfter = MeshOptimizer::ComputeACMR(finest, data.vertices.size());
+
+	// Vertex fetch optimization dropped unused vertices, so the count is final here
+	if (data.vertices.size() <= std::numeric_limits<uint16_t>::max())
+	{
+		data.shortIndices.assign(data.indices.begin(), data.indices.end());
+		data.indexData = data.shortIndices.data();
+		data.indexSize = sizeof(uint16_t);
+	}
+	else
+	{
+		data.indexData = data.indices.data();
+		data.indexSize = sizeof(uint32_t);
+	}
+	data.indexCount = data.indices.size();
+}
+
+void Entity::ComputeBounds(MeshData& data)
+{
+	if (data.vertexCount == 0) return;
+
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (size_t i = 0; i < data.vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, data.vertexData[i].pos);
+		boundsMax = glm::max(boundsMax, data.vertexData[i].pos);
+	}
+	data.boundsCenter = (boundsMin + boundsMax) * 0.5f;
+
+	data.boundsRadius = 0.f;
+	data.boundsInnerRadius = std::numeric_limits<float>::max();
+	for (size_t i = 0; i < data.vertexCount; i++)
+	{
+		float distance = glm::length(data.vertexData[i].pos - data.boundsCenter);
+		data.boundsRadius = std::max(data.boundsRadius, distance);
+		data.boundsInnerRadius = std::min(data.boundsInnerRadius, distance);
+	}
+}
+
+void Entity::Quantize(MeshData& data)
+{
+	glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+	glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+	for (size_t i = 0; i < data.vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, data.vertexData[i].pos);
+		boundsMax = glm::max(boundsMax, data.vertexData[i].pos);
+	}
+	data.positionOffset = boundsMin;
+	data.positionScale = glm::max(boundsMax - boundsMin, glm::vec3(1e-6f));
+
+	data.quantizedVertices.resize(data.vertexCount);
+	for (size_t i = 0; i < data.vertexCount; i++)
+	{
+		const Vertex& vertex = data.vertexData[i];
+		QuantizedVertex& quantized = data.quantizedVertices[i];
+		glm::vec3 pos = (vertex.pos - data.positionOffset) / data.positionScale;
+		for (int j = 0; j < 3; j++)
+			quantized.pos[j] =
+				static_cast<uint16_t>(glm::round(glm::clamp(pos[j], 0.f, 1.f) * 65535.f));
+		quantized.pos[3] = 0;
+		quantized.norm = glm::packSnorm3x10_1x2(glm::vec4(vertex.norm, 0.f));
+		quantized.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+		quantized.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+	}
+}
+
+void Entity::Import(const std::string& filename, float newScale, std::vector<Vertex>& vertices,
+					std::vector<uint32_t>& indices, std::string& texturePath)
 {
 	Assimp::Importer importer;
-	const aiScene* scene =
-		importer.ReadFile(filename, aiProcess_Triangulate | aiProcess_GenSmoothNormals |
-										aiProcess_JoinIdenticalVertices);
-	ProcessNode(scene, scene->mRootNode, m_Vertices, m_Indices);
+	const aiScene* scene = importer.ReadFile(filename, s_ImportFlags);
+	ProcessNode(scene, scene->mRootNode, vertices, indices, texturePath);
 
 	float xMin = 100000, xMax = -100000;
 	float yMin = 100000, yMax = -100000;
 	float zMin = 100000, zMax = -100000;
-	for (const auto& vertex : m_Vertices)
+	for (const auto& vertex : vertices)
 	{
 		xMin = std::min(xMin, vertex.pos[0]);
 		xMax = std::max(xMax, vertex.pos[0]);
@@ -48,25 +223,41 @@ void Entity::Load(const std::string& filename, float newScale, glm::u8vec4 color
 	float scale = std::max(scaleX, std::max(scaleY, scaleZ));
 	scale /= 2;
 
-	for (auto& vertex : m_Vertices)
+	for (auto& vertex : vertices)
 		vertex.pos = (vertex.pos + translate) / scale * newScale;
+}
 
-	if (m_Texture == 0)
-	{
-		int texWidth = 1, texHeight = 1;
-		auto* pixels = reinterpret_cast<stbi_uc*>(&color);
-		CreateTexture(m_Texture, pixels, texWidth, texHeight);
-	}
+void Entity::Upload(MeshData& data, glm::u8vec4 color, const std::string& normalMap,
+					AssetLoader* loader)
+{
+	auto texture = TextureCache::Load(data.texturePath, TextureFormat::RGBA8, loader);
+	auto normalTexture = TextureCache::Load(normalMap, TextureFormat::RGBA8, loader);
+	m_Color = color;
+
+	m_Lods = data.lods;
+	m_IndexSize = data.indexSize;
+	m_ImportStatistics = data.statistics;
+	m_IndexType = data.indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	m_BoundsCenter = data.boundsCenter;
+	m_BoundsRadius = data.boundsRadius;
+	m_BoundsInnerRadius = data.boundsInnerRadius;
+	m_PositionScale = data.positionScale;
+	m_PositionOffset = data.positionOffset;
 
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels =
-		stbi_load(normalMap.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	if (pixels)
+	if (m_Batch)
 	{
-		CreateTexture(m_NormalTexture, pixels, texWidth, texHeight);
-		stbi_image_free(pixels);
+		assert(data.format == VertexFormat::Quantized && "Batched meshes must be quantized");
+		m_BatchMesh = m_Batch->AddMesh(data.quantizedVertices.data(), data.quantizedVertices.size(),
+									   data.indexData, data.indexCount, data.indexSize);
+		// The batch keeps the textures until they are copied into its arrays
+		m_BatchTexture = m_Batch->AddTexture(texture);
+		m_BatchNormalTexture = m_Batch->AddTexture(normalTexture);
+		return;
 	}
 
+	m_Texture = texture ? texture : TextureCache::GetSolidColor(color);
+	m_NormalTexture = normalTexture;
+
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
@@ -74,50 +265,124 @@ void Entity::Load(const std::string& filename, float newScale, glm::u8vec4 color
 	glBindVertexArray(VAO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, m_Vertices.size() * sizeof(m_Vertices[0]), m_Vertices.data(),
-				 GL_STATIC_DRAW);
+	if (data.format == VertexFormat::Quantized)
+		glBufferData(GL_ARRAY_BUFFER, data.quantizedVertices.size() * sizeof(QuantizedVertex),
+					 data.quantizedVertices.data(), GL_STATIC_DRAW);
+	else
+		glBufferData(GL_ARRAY_BUFFER, data.vertexCount * sizeof(Vertex), data.vertexData,
+					 GL_STATIC_DRAW);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_Indices.size() * sizeof(m_Indices[0]), m_Indices.data(),
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indexCount * data.indexSize, data.indexData,
 				 GL_STATIC_DRAW);
 
-	// position attribute
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	// normal attribute
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-	// texture coord attribute
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
+	if (data.format == VertexFormat::Quantized)
+	{
+		GLsizei stride = sizeof(QuantizedVertex);
+		// position attribute
+		glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+							  (void*)offsetof(QuantizedVertex, pos));
+		glEnableVertexAttribArray(0);
+		// normal attribute
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+							  (void*)offsetof(QuantizedVertex, norm));
+		glEnableVertexAttribArray(1);
+		// texture coord attribute
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+							  (void*)offsetof(QuantizedVertex, texCoord));
+		glEnableVertexAttribArray(2);
+	}
+	else
+	{
+		// position attribute
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		// normal attribute
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+							  (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		// texture coord attribute
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+							  (void*)(6 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+	}
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 }
 
-void Entity::Render()
+void Entity::Submit(RenderQueue& queue, Shader& shader, const PerspectiveCamera& camera,
+					const glm::mat4& model, RenderPass pass)
 {
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_Texture);
-	if (m_NormalTexture)
+	if (m_Lods.empty()) return;
+	SelectLod(camera, model);
+	const MeshLod& lod = m_Lods[m_Lod];
+
+	if (m_Batch)
 	{
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, m_NormalTexture);
+		BatchDrawData data{};
+		data.model = model;
+		data.positionScale = glm::vec4(m_PositionScale, 0.f);
+		data.positionOffset = glm::vec4(m_PositionOffset, 0.f);
+		data.color = glm::vec4(m_Color) / 255.f;
+		m_Batch->Submit(m_BatchMesh, lod.indexOffset, lod.indexCount, data, m_BatchTexture,
+						m_BatchNormalTexture);
+		return;
 	}
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_Indices.size()), GL_UNSIGNED_INT, 0);
+
+	DrawCommand command;
+	command.name = m_Name.c_str();
+	command.pass = pass;
+	command.shader = &shader;
+	command.textures[0] = m_Texture.get();
+	command.textures[1] = m_NormalTexture.get();
+	command.vertexArray = VAO;
+	command.indexType = m_IndexType;
+	command.indexCount = lod.indexCount;
+	command.indexOffset = lod.indexOffset * m_IndexSize;
+	command.model = model;
+	command.positionScale = m_PositionScale;
+	command.positionOffset = m_PositionOffset;
+	glm::vec3 center = model * glm::vec4(m_BoundsCenter, 1.f);
+	command.depth = glm::length(camera.GetPosition() - center);
+	queue.Submit(std::move(command));
+}
+
+void Entity::SelectLod(const PerspectiveCamera& camera, const glm::mat4& model)
+{
+	glm::vec3 center = model * glm::vec4(m_BoundsCenter, 1.f);
+	float scale = std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])));
+	scale = std::max(scale, glm::length(glm::vec3(model[2])));
+
+	// Lower bound of the distance from the camera to the surface
+	float distance = glm::length(camera.GetPosition() - center);
+	distance = std::max(distance - m_BoundsRadius * scale, m_BoundsInnerRadius * scale - distance);
+	if (distance <= 0.f)
+	{
+		m_Lod = 0;
+		return;
+	}
+
+	// projection[1][1] is the cotangent of half the vertical field of view and NDC is 2 units high
+	float errorScale = scale * camera.GetProjectionMatrix()[1][1] / (2.f * distance);
+	auto getScreenError = [&](size_t lod) { return m_Lods[lod].error * errorScale; };
+	while (m_Lod > 0 && getScreenError(m_Lod) > s_LodScreenError * (1.f + s_LodHysteresis))
+		m_Lod--;
+	while (m_Lod + 1 < m_Lods.size() &&
+		   getScreenError(m_Lod + 1) < s_LodScreenError * (1.f - s_LodHysteresis))
+		m_Lod++;
 }
 
 void Entity::ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
-						 std::vector<uint32_t>& indices)
+						 std::vector<uint32_t>& indices, std::string& texturePath)
 {
 	for (size_t i = 0; i < node->mNumMeshes; i++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessMesh(scene, mesh, vertices, indices);
+		ProcessMesh(scene, mesh, vertices, indices, texturePath);
 	}
 	for (size_t i = 0; i < node->mNumChildren; i++)
-		ProcessNode(scene, node->mChildren[i], vertices, indices);
+		ProcessNode(scene, node->mChildren[i], vertices, indices, texturePath);
 }
 
 static inline std::string GetFileName(const std::string& path)
@@ -133,7 +398,7 @@ static inline std::string GetFileName(const std::string& path)
 }
 
 void Entity::ProcessMesh(const aiScene* scene, const aiMesh* mesh, std::vector<Vertex>& vertices,
-						 std::vector<uint32_t>& indices)
+						 std::vector<uint32_t>& indices, std::string& texturePath)
 {
 	uint32_t meshSizeBefore = static_cast<uint32_t>(vertices.size());
 	size_t newIndicesCount = 0;
@@ -168,28 +433,8 @@ void Entity::ProcessMesh(const aiScene* scene, const aiMesh* mesh, std::vector<V
 	{
 		aiString txt;
 		material->GetTexture(aiTextureType_DIFFUSE, 0, &txt);
-		std::string texturePath = "textures/" + GetFileName(txt.C_Str());
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels =
-			stbi_load(texturePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		assert(pixels);
-		CreateTexture(m_Texture, pixels, texWidth, texHeight);
-		stbi_image_free(pixels);
+		texturePath = "textures/" + GetFileName(txt.C_Str());
 	}
 
 	aiMaterial* aiMaterial = scene->mMaterials[mesh->mMaterialIndex];
 }
-
-void Entity::CreateTexture(uint32_t& texture, unsigned char* pixels, GLsizei texWidth,
-						   GLsizei texHeight)
-{
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-				 pixels);
-	glGenerateMipmap(GL_TEXTURE_2D);
-}
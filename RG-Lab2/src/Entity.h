@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -7,8 +8,14 @@
 #include <glm/glm.hpp>
 
 #include "assimp/Importer.hpp"
+#include "assimp/postprocess.h"
 #include "assimp/scene.h"
 
+#include "PerspectiveCamera.h"
+#include "RenderQueue.h"
+#include "StaticBatch.h"
+#include "TextureCache.h"
+
 struct Vertex
 {
 	glm::vec3 pos;
@@ -16,29 +23,147 @@ struct Vertex
 	glm::vec2 texCoord;
 };
 
+// Compressed layout: positions as unsigned normalized 16-bit values within the mesh bounds (w is
+// padding), normals packed as GL_INT_2_10_10_10_REV and texture coordinates as half floats. The
+// vertex shaders rebuild positions with the positionScale/positionOffset uniforms.
+struct QuantizedVertex
+{
+	uint16_t pos[4];
+	uint32_t norm;
+	uint16_t texCoord[2];
+};
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must stay 16 bytes");
+
+// Range of the shared index buffer drawn for one level of detail. error is the largest surface
+// deviation simplification introduced, in mesh units; the full resolution level has none.
+struct MeshLod
+{
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	float error;
+};
+
+// Vertex cache efficiency of the finest level before and after optimization. Only measured when
+// the mesh is imported, a mesh read from the mesh cache was optimized in an earlier run.
+struct ImportStatistics
+{
+	bool optimized = false;
+	float acmrBefore = 0.f;
+	float acmrAfter = 0.f;
+};
+
+enum class VertexFormat
+{
+	Float,
+	Quantized
+};
+
+class AssetLoader;
+
 class Entity
 {
 public:
 	Entity() = default;
 	~Entity();
 	void Load(const std::string& filename, float newScale, glm::u8vec4 color,
-			  const std::string& normalMap = "");
-	void Render();
+			  const std::string& normalMap = "", VertexFormat format = VertexFormat::Float);
+	void LoadAsync(AssetLoader& loader, const std::string& filename, float newScale,
+				   glm::u8vec4 color, const std::string& normalMap = "",
+				   VertexFormat format = VertexFormat::Float);
+	// Frees the mesh buffers and drops the textures, the cache releases those left unused. A
+	// batched mesh keeps its arena range, the batch only grows.
+	void Unload();
+	// Set before loading a quantized mesh: it is then uploaded into the batch arenas instead of
+	// buffers of its own, and Submit queues it on the batch rather than the render queue
+	void SetBatch(StaticBatch* batch)
+	{
+		m_Batch = batch;
+	}
+	// Queues the coarsest level whose error covers less than s_LodScreenError of the screen height
+	void Submit(RenderQueue& queue, Shader& shader, const PerspectiveCamera& camera,
+				const glm::mat4& model, RenderPass pass = RenderPass::Opaque);
+
+	size_t GetLod() const
+	{
+		return m_Lod;
+	}
+	size_t GetLodCount() const
+	{
+		return m_Lods.size();
+	}
+	size_t GetTriangleCount(size_t lod) const
+	{
+		return m_Lods.empty() ? 0 : m_Lods[lod].indexCount / 3;
+	}
+	size_t GetIndexSize() const
+	{
+		return m_IndexSize;
+	}
+	const ImportStatistics& GetImportStatistics() const
+	{
+		return m_ImportStatistics;
+	}
+
+	const glm::vec3& GetPositionScale() const
+	{
+		return m_PositionScale;
+	}
+	const glm::vec3& GetPositionOffset() const
+	{
+		return m_PositionOffset;
+	}
 
 private:
-	void ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
-					 std::vector<uint32_t>& indices);
-	void ProcessMesh(const aiScene* scene, const aiMesh* mesh, std::vector<Vertex>& vertices,
-							std::vector<uint32_t>& indices);
-	void CreateTexture(uint32_t& texture, unsigned char* pixels, GLsizei texWidth,
-					   GLsizei texHeight);
+	// CPU side of a load, filled on a worker thread and consumed by Upload on the GL thread
+	struct MeshData;
+
+	static void Read(MeshData& data, const std::string& filename, float newScale,
+					 VertexFormat format);
+	static void Optimize(MeshData& data);
+	static void ComputeBounds(MeshData& data);
+	static void Quantize(MeshData& data);
+	static void Import(const std::string& filename, float newScale, std::vector<Vertex>& vertices,
+					   std::vector<uint32_t>& indices, std::string& texturePath);
+	static void ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
+							std::vector<uint32_t>& indices, std::string& texturePath);
+	static void ProcessMesh(const aiScene* scene, const aiMesh* mesh,
+							std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+							std::string& texturePath);
+	void Upload(MeshData& data, glm::u8vec4 color, const std::string& normalMap,
+				AssetLoader* loader);
+	void SelectLod(const PerspectiveCamera& camera, const glm::mat4& model);
 
 private:
-	std::vector<uint32_t> m_Indices{};
-	std::vector<Vertex> m_Vertices{};
+	static constexpr uint32_t s_ImportFlags =
+		aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices;
+	static constexpr size_t s_LodCount = 4;
+	// Allowed error as a fraction of the screen height (a pixel at 1080 lines), and the relative
+	// band around it in which the current level is kept to avoid popping back and forth
+	static constexpr float s_LodScreenError = 1.f / 1080.f;
+	static constexpr float s_LodHysteresis = 0.25f;
+
+	std::string m_Name{};
+	std::vector<MeshLod> m_Lods{};
+	size_t m_Lod = 0;
+	GLenum m_IndexType = GL_UNSIGNED_INT;
+	size_t m_IndexSize = sizeof(uint32_t);
+	ImportStatistics m_ImportStatistics{};
+	// Every vertex lies between the two radii around the center, which bounds the distance from
+	// the camera to the surface both outside the mesh and inside shells like the sky dome
+	glm::vec3 m_BoundsCenter{0.f};
+	float m_BoundsRadius = 0.f;
+	float m_BoundsInnerRadius = 0.f;
+	glm::vec3 m_PositionScale{1.f};
+	glm::vec3 m_PositionOffset{0.f};
+	StaticBatch* m_Batch = nullptr;
+	BatchMesh m_BatchMesh{};
+	// Batch texture handles, a batched mesh without a texture is drawn with m_Color
+	int32_t m_BatchTexture = -1;
+	int32_t m_BatchNormalTexture = -1;
+	glm::u8vec4 m_Color{255};
 	uint32_t VBO{};
 	uint32_t VAO{};
 	uint32_t EBO{};
-	uint32_t m_Texture{};
-	uint32_t m_NormalTexture{};
+	std::shared_ptr<Texture> m_Texture{};
+	std::shared_ptr<Texture> m_NormalTexture{};
 };
@@ -3,19 +3,24 @@
 #include <memory>
 #include <string>
 
+#include "AssetLoader.h"
 #include "BSplineCurve.h"
 #include "Entity.h"
 #include "GLFW/glfw3.h"
 #include "PerspectiveCameraController.h"
+#include "RenderQueue.h"
 #include "Shader.h"
+#include "StaticBatch.h"
+#include "UniformBuffer.h"
 #include "Particle.h"
 
 class Game
 {
 public:
-	static void CreateGame(const std::string& title, int width, int height)
+	// A headless game renders into an offscreen framebuffer of an invisible window
+	static void CreateGame(const std::string& title, int width, int height, bool headless = false)
 	{
-		Game* game = new Game(title, width, height);
+		Game* game = new Game(title, width, height, headless);
 		s_Game = std::unique_ptr<Game>(game);
 	}
 	static Game& Get()
@@ -42,32 +47,61 @@ public:
 	{
 		return m_Window;
 	}
+	// True once every asynchronously loaded asset has been uploaded
+	bool IsLoaded() const
+	{
+		return m_AssetLoader.IsIdle();
+	}
+
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& target)
+	{
+		m_CameraController.GetCamera().SetPosition(position, target);
+	}
 
 private:
-	Game(const std::string& title, int width, int height);
+	Game(const std::string& title, int width, int height, bool headless);
 
 private:
 	static void OnKeyPressed(GLFWwindow* window, int key, int scancode, int action, int mods);
 	static void OnWindowResized(GLFWwindow* window, int width, int height);
 
+	void PrintLodStatistics() const;
+
 private:
 	GLFWwindow* m_Window = nullptr;
 
 	bool m_Minimized = false;
+	bool m_Headless = false;
+	uint32_t m_Framebuffer = 0;
+	uint32_t m_ColorRenderbuffer = 0;
+	uint32_t m_DepthRenderbuffer = 0;
+	std::string m_Title;
+
+	// Profiler results shown in the window title, refreshed a few times per second
+	bool m_ShowProfiler = false;
+	float m_ProfilerRefreshTimer = 0.f;
+	const float m_ProfilerRefreshInterval = 500.f;
 
 	PerspectiveCameraController m_CameraController;
 
 	Entity m_Object{};
 	Entity m_Land{};
 	Entity m_Skydome{};
+	// Object and land, drawn together with one indirect multi-draw
+	StaticBatch m_StaticBatch{};
 	std::vector<std::shared_ptr<ParticleSystem>> m_ParticleSystems;
 
 	BSplineCurve m_BSpline{};
 
-	std::shared_ptr<Shader> m_ObjectShader{};
-	std::shared_ptr<Shader> m_LandShader{};
+	// Declared after the entities so workers are joined before anything they load into is gone
+	AssetLoader m_AssetLoader{};
+	const float m_UploadBudget = 4.f;
+
+	UniformBuffer m_CameraBuffer{};
+	RenderQueue m_RenderQueue{};
+
+	std::shared_ptr<Shader> m_BatchShader{};
 	std::shared_ptr<Shader> m_SkydomeShader{};
-	std::shared_ptr<Shader> m_MarkerShader{};
 	std::shared_ptr<Shader> m_ParticleShader{};
 
 private:
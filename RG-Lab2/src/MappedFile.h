@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file mapped into the address space. Pages are brought in by the OS
+// on first touch, so large files cost nothing until the parts that are actually read.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_Data != nullptr;
+	}
+	const uint8_t* GetData() const
+	{
+		return m_Data;
+	}
+	size_t GetSize() const
+	{
+		return m_Size;
+	}
+
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#endif
+};
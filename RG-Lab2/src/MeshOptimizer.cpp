@@ -0,0 +1,466 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// Sum of squared distances to a set of planes, weighted by triangle area
+struct Quadric
+{
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2;
+	double c;
+	double weight;
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		a00 += other.a00, a11 += other.a11, a22 += other.a22;
+		a01 += other.a01, a02 += other.a02, a12 += other.a12;
+		b0 += other.b0, b1 += other.b1, b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+};
+
+static Quadric MakePlaneQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+{
+	glm::dvec3 normal = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+	double length = glm::length(normal);
+	if (length <= 0.0) return Quadric{};
+	normal /= length;
+	double area = length * 0.5;
+	double d = -glm::dot(normal, glm::dvec3(p0));
+
+	Quadric q;
+	q.a00 = area * normal.x * normal.x, q.a11 = area * normal.y * normal.y;
+	q.a22 = area * normal.z * normal.z, q.a01 = area * normal.x * normal.y;
+	q.a02 = area * normal.x * normal.z, q.a12 = area * normal.y * normal.z;
+	q.b0 = area * d * normal.x, q.b1 = area * d * normal.y, q.b2 = area * d * normal.z;
+	q.c = area * d * d;
+	q.weight = area;
+	return q;
+}
+
+// Root mean square distance of p to the planes accumulated in q
+static float EvaluateQuadric(const Quadric& q, const glm::vec3& p)
+{
+	if (q.weight <= 0.0) return 0.f;
+	double x = p.x, y = p.y, z = p.z;
+	double error = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+				   2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+				   2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+	return static_cast<float>(std::sqrt(std::max(error, 0.0) / q.weight));
+}
+
+static float ComputeVertexScore(int cachePosition, uint32_t remainingTriangles, size_t cacheSize)
+{
+	if (remainingTriangles == 0) return -1.f;
+
+	float score = 0.f;
+	if (cachePosition >= 0)
+	{
+		// The last triangle's vertices get a fixed score so it is not favoured over its neighbours
+		if (cachePosition < 3) { score = 0.75f; }
+		else
+		{
+			float scaler = 1.f / (cacheSize - 3);
+			score = std::pow(1.f - (cachePosition - 3) * scaler, 1.5f);
+		}
+	}
+	// Boost vertices with few triangles left so they get finished off and leave the cache
+	return score + 2.f / std::sqrt(static_cast<float>(remainingTriangles));
+}
+
+std::vector<MeshLod> MeshOptimizer::Optimize(std::vector<Vertex>& vertices,
+											 std::vector<uint32_t>& indices, size_t lodCount)
+{
+	std::vector<MeshLod> lods;
+	std::vector<uint32_t> result;
+	std::vector<uint32_t> lodIndices = indices;
+	float error = 0.f;
+	for (size_t level = 0; level < lodCount; level++)
+	{
+		if (level > 0)
+		{
+			// Every level halves the triangle count of the previous one
+			size_t previousCount = lodIndices.size();
+			error = std::max(error, Simplify(lodIndices, vertices, previousCount / 6 * 3));
+			if (lodIndices.empty() || lodIndices.size() > previousCount * 3 / 4) break;
+		}
+		OptimizeVertexCache(lodIndices, vertices.size());
+		OptimizeOverdraw(lodIndices, vertices);
+		lods.push_back({static_cast<uint32_t>(result.size()),
+						static_cast<uint32_t>(lodIndices.size()), error});
+		result.insert(result.end(), lodIndices.begin(), lodIndices.end());
+	}
+
+	// Coarser levels only reference vertices of the finest one, so it decides the vertex order
+	OptimizeVertexFetch(vertices, result);
+	indices.swap(result);
+	return lods;
+}
+
+float MeshOptimizer::Simplify(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+							  size_t targetIndexCount)
+{
+	size_t vertexCount = vertices.size();
+	std::vector<bool> locked(vertexCount, false);
+
+	// Vertices sharing a position with another one sit on an attribute seam
+	std::vector<uint32_t> sorted(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		sorted[i] = static_cast<uint32_t>(i);
+	auto lessPosition = [&vertices](uint32_t a, uint32_t b) {
+		const glm::vec3& pa = vertices[a].pos;
+		const glm::vec3& pb = vertices[b].pos;
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		return pa.z < pb.z;
+	};
+	std::sort(sorted.begin(), sorted.end(), lessPosition);
+	for (size_t i = 1; i < vertexCount; i++)
+	{
+		if (vertices[sorted[i - 1]].pos == vertices[sorted[i]].pos)
+			locked[sorted[i - 1]] = locked[sorted[i]] = true;
+	}
+
+	// Edges used by a single triangle are open borders, more than two make the mesh non-manifold
+	std::unordered_map<uint64_t, uint32_t> edgeUses;
+	edgeUses.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint64_t a = indices[i + j], b = indices[i + (j + 1) % 3];
+			edgeUses[std::min(a, b) << 32 | std::max(a, b)]++;
+		}
+	}
+	for (const auto& [edge, uses] : edgeUses)
+	{
+		if (uses != 2) locked[edge >> 32] = locked[edge & 0xffffffff] = true;
+	}
+
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		Quadric q = MakePlaneQuadric(vertices[indices[i]].pos, vertices[indices[i + 1]].pos,
+									 vertices[indices[i + 2]].pos);
+		for (size_t j = 0; j < 3; j++)
+			quadrics[indices[i + j]] += q;
+	}
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float error;
+	};
+
+	float maxError = 0.f;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<uint32_t> offsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	while (indices.size() > targetIndexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		// Interior edges show up once in each direction, so every triangle edge is one candidate
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (size_t j = 0; j < 3; j++)
+			{
+				uint32_t from = indices[i + j], to = indices[i + (j + 1) % 3];
+				if (locked[from]) continue;
+				Quadric q = quadrics[from];
+				q += quadrics[to];
+				collapses.push_back({from, to, EvaluateQuadric(q, vertices[to].pos)});
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(),
+				  [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (uint32_t index : indices)
+			offsets[index + 1]++;
+		for (size_t i = 0; i < vertexCount; i++)
+			offsets[i + 1] += offsets[i];
+		adjacency.resize(indices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		for (size_t i = 0; i < vertexCount; i++)
+			remap[i] = static_cast<uint32_t>(i);
+		std::fill(touched.begin(), touched.end(), false);
+
+		// Removing at most a quarter per pass keeps the choice of collapses close to cost order
+		size_t passTarget = std::max(targetIndexCount / 3, triangleCount - triangleCount / 4);
+		size_t remaining = triangleCount;
+		for (const Collapse& collapse : collapses)
+		{
+			if (remaining <= passTarget) break;
+			if (touched[collapse.from] || touched[collapse.to]) continue;
+
+			// Reject collapses that would flip a surrounding triangle
+			bool flips = false;
+			size_t removed = 0;
+			for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1]; j++)
+			{
+				const uint32_t* triangle = &indices[adjacency[j] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+					triangle[2] == collapse.to)
+				{
+					removed++;
+					continue;
+				}
+				glm::vec3 p[3], q[3];
+				for (size_t k = 0; k < 3; k++)
+				{
+					p[k] = vertices[triangle[k]].pos;
+					q[k] = triangle[k] == collapse.from ? vertices[collapse.to].pos : p[k];
+				}
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+				if (glm::dot(before, after) <= 0.f)
+				{
+					flips = true;
+					break;
+				}
+			}
+			if (flips) continue;
+
+			remap[collapse.from] = collapse.to;
+			quadrics[collapse.to] += quadrics[collapse.from];
+			maxError = std::max(maxError, collapse.error);
+			remaining -= removed;
+
+			// Triangles around the collapsed vertex changed, freeze them for the rest of the pass
+			for (uint32_t j = offsets[collapse.from]; j < offsets[collapse.from + 1]; j++)
+			{
+				const uint32_t* triangle = &indices[adjacency[j] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+			}
+		}
+		if (remaining == triangleCount) break;
+
+		size_t count = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+			if (a == b || b == c || a == c) continue;
+			indices[count++] = a;
+			indices[count++] = b;
+			indices[count++] = c;
+		}
+		indices.resize(count);
+	}
+
+	return maxError;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// Triangles adjacent to every vertex, packed in one array
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t index : indices)
+		remaining[index]++;
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; i++)
+		offsets[i + 1] = offsets[i] + remaining[i];
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		vertexScores[i] = ComputeVertexScore(-1, remaining[i], s_CacheSize);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t i = 0; i < triangleCount; i++)
+		triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] +
+							vertexScores[indices[i * 3 + 2]];
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	std::vector<uint32_t> cache, newCache;
+	cache.reserve(s_CacheSize + 3);
+	newCache.reserve(s_CacheSize + 3);
+
+	size_t nextUnemitted = 0;
+	int64_t best = -1;
+	while (result.size() < indices.size())
+	{
+		if (best < 0)
+		{
+			// Nothing adjacent to the cache is left, continue with the next triangle in order
+			while (emitted[nextUnemitted])
+				nextUnemitted++;
+			best = static_cast<int64_t>(nextUnemitted);
+		}
+
+		const uint32_t* triangle = &indices[best * 3];
+		emitted[best] = true;
+		newCache.assign(triangle, triangle + 3);
+		for (size_t i = 0; i < 3; i++)
+		{
+			result.push_back(triangle[i]);
+			remaining[triangle[i]]--;
+		}
+		for (uint32_t vertex : cache)
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache.push_back(vertex);
+
+		// Rescore everything that was or is in the cache, evicted vertices included
+		for (size_t i = 0; i < newCache.size(); i++)
+		{
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < s_CacheSize ? static_cast<int>(i) : -1;
+			float score =
+				ComputeVertexScore(cachePositions[vertex], remaining[vertex], s_CacheSize);
+			float delta = score - vertexScores[vertex];
+			vertexScores[vertex] = score;
+			for (uint32_t j = offsets[vertex]; j < offsets[vertex + 1]; j++)
+				if (!emitted[adjacency[j]]) triangleScores[adjacency[j]] += delta;
+		}
+		if (newCache.size() > s_CacheSize) newCache.resize(s_CacheSize);
+		std::swap(cache, newCache);
+
+		best = -1;
+		float bestScore = std::numeric_limits<float>::lowest();
+		for (uint32_t vertex : cache)
+		{
+			for (uint32_t j = offsets[vertex]; j < offsets[vertex + 1]; j++)
+			{
+				uint32_t candidate = adjacency[j];
+				if (!emitted[candidate] && triangleScores[candidate] > bestScore)
+				{
+					bestScore = triangleScores[candidate];
+					best = candidate;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices,
+									 const std::vector<Vertex>& vertices)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) return;
+
+	// A triangle missing the cache with all three vertices starts a new cluster, so moving clusters
+	// around barely changes the cache behaviour established by OptimizeVertexCache
+	std::vector<size_t> clusterStarts;
+	std::vector<uint32_t> timestamps(vertices.size(), 0);
+	uint32_t time = static_cast<uint32_t>(s_CacheSize) + 1;
+	for (size_t i = 0; i < triangleCount; i++)
+	{
+		int misses = 0;
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint32_t index = indices[i * 3 + j];
+			if (time - timestamps[index] > s_CacheSize)
+			{
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+		if (i == 0 || misses == 3) clusterStarts.push_back(i);
+	}
+	clusterStarts.push_back(triangleCount);
+	size_t clusterCount = clusterStarts.size() - 1;
+
+	std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.f));
+	std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.f));
+	std::vector<float> areas(clusterCount, 0.f);
+	glm::vec3 meshCentroid(0.f);
+	float meshArea = 0.f;
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		for (size_t i = clusterStarts[c]; i < clusterStarts[c + 1]; i++)
+		{
+			const glm::vec3& p0 = vertices[indices[i * 3]].pos;
+			const glm::vec3& p1 = vertices[indices[i * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[i * 3 + 2]].pos;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+			centroids[c] += (p0 + p1 + p2) * (area / 3.f);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+	}
+	if (meshArea > 0.f) meshCentroid /= meshArea;
+
+	// Clusters facing away from the centre of the mesh are likely in front, draw them first
+	std::vector<float> keys(clusterCount, 0.f);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		if (areas[c] <= 0.f || glm::dot(normals[c], normals[c]) <= 0.f) continue;
+		keys[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, glm::normalize(normals[c]));
+	}
+	std::vector<size_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(),
+					 [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (size_t c : order)
+		result.insert(result.end(), indices.begin() + clusterStarts[c] * 3,
+					  indices.begin() + clusterStarts[c + 1] * 3);
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices,
+										std::vector<uint32_t>& indices)
+{
+	const uint32_t unused = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+	for (auto& index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(result);
+}
+
+float MeshOptimizer::ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount,
+								 size_t cacheSize)
+{
+	if (indices.size() < 3) return 0.f;
+
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = static_cast<uint32_t>(cacheSize) + 1;
+	size_t misses = 0;
+	for (uint32_t index : indices)
+	{
+		if (time - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = time++;
+			misses++;
+		}
+	}
+	return static_cast<float>(misses) / (indices.size() / 3);
+}
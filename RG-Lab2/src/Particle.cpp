@@ -6,7 +6,6 @@
 
 #include "PerspectiveCamera.h"
 #include "glm/gtx/norm.hpp"
-#include "stb_image.h"
 
 glm::vec3 GetRandomPoint(glm::vec2 dx, glm::vec2 dy, glm::vec2 dz)
 {
@@ -68,12 +67,8 @@ ParticleSystem::ParticleSystem(const glm::vec3& position)
 
 	glBindVertexArray(0);
 
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load("textures/Flame_Particle.png", &texWidth, &texHeight, &texChannels,
-								STBI_rgb_alpha);
-	assert(pixels);
-	CreateTexture(m_ParticleTexture, pixels, texWidth, texHeight);
-	stbi_image_free(pixels);
+	m_ParticleTexture = TextureCache::Load("textures/Flame_Particle.png");
+	assert(m_ParticleTexture);
 
 	m_FreeIndices.reserve(MAX_PARTICLES);
 	for (int i = 0; i < MAX_PARTICLES; i++)
@@ -94,8 +89,7 @@ void ParticleSystem::Render(const PerspectiveCamera& camera)
 
 	glDepthMask(false);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_ParticleTexture);
+	m_ParticleTexture->Bind(0);
 
 	for (int i = 0; i < MAX_PARTICLES; i++)
 	{
@@ -175,17 +169,3 @@ void ParticleSystem::Update(float deltaMiliseconds, glm::vec3 jetPosition, glm::
 		if (m_Particles[i].Update(deltaMiliseconds)) { m_FreeIndices.push_back(i); }
 	}
 }
-
-void ParticleSystem::CreateTexture(uint32_t& texture, unsigned char* pixels, GLsizei texWidth,
-								   GLsizei texHeight)
-{
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-				 pixels);
-	glGenerateMipmap(GL_TEXTURE_2D);
-}
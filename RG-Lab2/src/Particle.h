@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Shader.h"
+#include "TextureCache.h"
 
 #include <glm/glm.hpp>
 #include <memory>
@@ -62,8 +63,6 @@ public:
 private:
 	void SpawnParticle(glm::vec3 initialVelocity);
 	void SpawnParticle(uint32_t index, glm::vec3 initialVelocity);
-	void CreateTexture(uint32_t& texture, unsigned char* pixels, GLsizei texWidth,
-					   GLsizei texHeight);
 
 private:
 	glm::vec3 m_Position{};
@@ -85,5 +84,5 @@ private:
 	uint32_t m_VertexBuffer{};
 	uint32_t m_PositionsBuffer{};
 	uint32_t m_ColorsBuffer{};
-	uint32_t m_ParticleTexture{};
+	std::shared_ptr<Texture> m_ParticleTexture{};
 };
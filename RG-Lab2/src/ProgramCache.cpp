@@ -0,0 +1,107 @@
+#include "ProgramCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <vector>
+
+static const char* s_CacheDirectory = "cache/shaders";
+
+uint32_t ProgramCache::Load(const std::string& name, const std::string& source)
+{
+	if (!IsSupported()) return 0;
+
+	std::ifstream fs(GetCachePath(name), std::ios::binary);
+	Header header{};
+	if (!fs.read(reinterpret_cast<char*>(&header), sizeof(header))) return 0;
+	if (std::memcmp(header.magic, "PROG", 4) != 0 || header.version != s_Version ||
+		header.sourceHash != std::hash<std::string>{}(source) ||
+		header.driverHash != GetDriverHash())
+		return 0;
+
+	std::vector<char> binary(header.binarySize);
+	if (!fs.read(binary.data(), binary.size())) return 0;
+
+	// Drivers may still refuse a binary they produced, e.g. after a settings change
+	uint32_t program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary.data(),
+					static_cast<GLsizei>(binary.size()));
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ProgramCache::PrepareForStore(uint32_t program)
+{
+	if (IsSupported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Store(const std::string& name, const std::string& source, uint32_t program)
+{
+	if (!IsSupported()) return;
+
+	int success, length;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!success || length <= 0) return;
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat;
+	glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+	Header header{};
+	std::memcpy(header.magic, "PROG", 4);
+	header.version = s_Version;
+	header.sourceHash = std::hash<std::string>{}(source);
+	header.driverHash = GetDriverHash();
+	header.binaryFormat = binaryFormat;
+	header.binarySize = static_cast<uint32_t>(length);
+
+	std::error_code error;
+	std::filesystem::create_directories(s_CacheDirectory, error);
+
+	// Write next to the final entry and rename, so a crash never leaves a truncated cache behind
+	std::string cachePath = GetCachePath(name);
+	std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream fs(tempPath, std::ios::binary | std::ios::trunc);
+		if (!fs) return;
+		fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fs.write(binary.data(), length);
+		if (!fs) return;
+	}
+	std::filesystem::rename(tempPath, cachePath, error);
+}
+
+bool ProgramCache::IsSupported()
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+std::string ProgramCache::GetCachePath(const std::string& name)
+{
+	std::ostringstream sstream;
+	sstream << s_CacheDirectory << "/" << std::hex << std::hash<std::string>{}(name) << ".bin";
+	return sstream.str();
+}
+
+uint64_t ProgramCache::GetDriverHash()
+{
+	std::string driver;
+	for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+	{
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		driver += value ? value : "";
+		driver += '\n';
+	}
+	return std::hash<std::string>{}(driver);
+}
@@ -0,0 +1,94 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Profiler.h"
+
+void RenderQueue::Submit(DrawCommand command)
+{
+	assert(command.shader);
+	m_Commands.push_back(std::move(command));
+}
+
+void RenderQueue::Flush()
+{
+	m_Keys.clear();
+	for (uint32_t i = 0; i < m_Commands.size(); i++)
+		m_Keys.emplace_back(MakeKey(m_Commands[i]), i);
+	std::sort(m_Keys.begin(), m_Keys.end());
+
+	m_Statistics = {};
+	const Shader* currentShader = nullptr;
+	const Texture* currentTextures[2]{};
+	uint32_t currentVertexArray = 0;
+	for (const auto& [key, index] : m_Keys)
+	{
+		DrawCommand& command = m_Commands[index];
+		ProfileScope scope(command.name);
+		if (command.shader != currentShader)
+		{
+			command.shader->Use();
+			currentShader = command.shader;
+			m_Statistics.programChanges++;
+		}
+		for (uint32_t slot = 0; slot < 2; slot++)
+		{
+			const Texture* texture = command.textures[slot];
+			if (texture && texture != currentTextures[slot])
+			{
+				texture->Bind(slot);
+				currentTextures[slot] = texture;
+				m_Statistics.textureChanges++;
+			}
+		}
+		if (command.vertexArray && command.vertexArray != currentVertexArray)
+		{
+			glBindVertexArray(command.vertexArray);
+			currentVertexArray = command.vertexArray;
+			m_Statistics.vertexArrayChanges++;
+		}
+		m_Statistics.drawCalls++;
+
+		if (command.draw)
+		{
+			command.draw(*command.shader);
+			// The callback may have bound textures and vertex arrays of its own
+			currentTextures[0] = currentTextures[1] = nullptr;
+			currentVertexArray = 0;
+			continue;
+		}
+
+		command.shader->SetMat4f("model", command.model);
+		command.shader->SetVec3f("positionScale", command.positionScale);
+		command.shader->SetVec3f("positionOffset", command.positionOffset);
+		glDrawElements(GL_TRIANGLES, command.indexCount, command.indexType,
+					   (void*)command.indexOffset);
+	}
+
+	m_Commands.clear();
+}
+
+void RenderQueue::PrintStatistics() const
+{
+	std::cout << "Render queue: " << m_Statistics.drawCalls << " draws, "
+			  << m_Statistics.programChanges << " program changes, "
+			  << m_Statistics.textureChanges << " texture changes, "
+			  << m_Statistics.vertexArrayChanges << " vertex array changes" << std::endl;
+}
+
+uint64_t RenderQueue::MakeKey(const DrawCommand& command)
+{
+	// pass : 4 | program : 12 | texture : 16 | depth : 32. Non-negative floats order the same as
+	// their bit patterns, flipping them sorts back to front.
+	float depth = std::max(command.depth, 0.f);
+	uint32_t depthBits;
+	std::memcpy(&depthBits, &depth, sizeof(depthBits));
+	if (command.pass == RenderPass::Transparent) depthBits = ~depthBits;
+
+	uint64_t texture = command.textures[0] ? command.textures[0]->GetID() : 0;
+	return static_cast<uint64_t>(command.pass) << 60 |
+		   static_cast<uint64_t>(command.shader->GetID() & 0xfff) << 48 | (texture & 0xffff) << 32 |
+		   depthBits;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+// Basis matrices are stored by ascending power of t: Matrix[k][j] is the coefficient of t^k
+// for the j-th control point of a segment. They are built at compile time so the evaluation in
+// Spline<Basis> can be folded into plain polynomial arithmetic.
+template<size_t N>
+using BasisMatrix = std::array<std::array<float, N + 1>, N + 1>;
+
+namespace SplineMath
+{
+constexpr float Binomial(size_t n, size_t k)
+{
+	if (k > n) return 0.f;
+	float result = 1.f;
+	for (size_t i = 1; i <= k; i++)
+		result = result * (n - k + i) / i;
+	return result;
+}
+
+constexpr float Power(float x, size_t n)
+{
+	float result = 1.f;
+	for (size_t i = 0; i < n; i++)
+		result *= x;
+	return result;
+}
+
+constexpr float Factorial(size_t n)
+{
+	float result = 1.f;
+	for (size_t i = 2; i <= n; i++)
+		result *= i;
+	return result;
+}
+} // namespace SplineMath
+
+template<size_t N>
+struct UniformBSplineBasis
+{
+	static constexpr size_t Degree = N;
+	static constexpr size_t Stride = 1;
+
+	static constexpr BasisMatrix<N> MakeMatrix()
+	{
+		BasisMatrix<N> m{};
+		for (size_t k = 0; k <= N; k++)
+		{
+			for (size_t j = 0; j <= N; j++)
+			{
+				float sum = 0.f;
+				for (size_t s = j; s <= N; s++)
+				{
+					float sign = (s - j) % 2 ? -1.f : 1.f;
+					sum += sign * SplineMath::Binomial(N + 1, s - j) *
+						   SplineMath::Power(static_cast<float>(N - s), N - k);
+				}
+				m[k][j] = SplineMath::Binomial(N, k) * sum / SplineMath::Factorial(N);
+			}
+		}
+		return m;
+	}
+
+	static constexpr BasisMatrix<N> Matrix = MakeMatrix();
+};
+
+template<size_t N>
+struct BezierBasis
+{
+	static constexpr size_t Degree = N;
+	static constexpr size_t Stride = N;
+
+	static constexpr BasisMatrix<N> MakeMatrix()
+	{
+		BasisMatrix<N> m{};
+		for (size_t k = 0; k <= N; k++)
+		{
+			for (size_t j = 0; j <= k; j++)
+			{
+				float sign = (k - j) % 2 ? -1.f : 1.f;
+				m[k][j] = sign * SplineMath::Binomial(N, j) * SplineMath::Binomial(N - j, k - j);
+			}
+		}
+		return m;
+	}
+
+	static constexpr BasisMatrix<N> Matrix = MakeMatrix();
+};
+
+template<size_t N>
+struct CatmullRomBasis
+{
+	static_assert(N == 3, "Catmull-Rom splines are only defined for cubic segments");
+
+	static constexpr size_t Degree = N;
+	static constexpr size_t Stride = 1;
+
+	static constexpr BasisMatrix<N> Matrix{{{0.f, 1.f, 0.f, 0.f},
+											{-0.5f, 0.f, 0.5f, 0.f},
+											{1.f, -2.5f, 2.f, -0.5f},
+											{-0.5f, 1.5f, -1.5f, 0.5f}}};
+};
+
+template<typename Basis>
+class Spline
+{
+public:
+	static constexpr size_t Degree = Basis::Degree;
+	static constexpr size_t PointsPerSegment = Degree + 1;
+
+	static size_t GetSegmentCount(size_t pointCount)
+	{
+		if (pointCount < PointsPerSegment) return 0;
+		return (pointCount - PointsPerSegment) / Basis::Stride + 1;
+	}
+
+	static size_t GetFirstPoint(size_t segment)
+	{
+		return segment * Basis::Stride;
+	}
+
+	// Evaluates the given derivative of the segment whose control points start at points. The
+	// scalar basis weights are found first, so the points are combined only once, and every
+	// loop is a fold expression so its speed does not depend on the optimizer unrolling it.
+	template<size_t Derivative = 0>
+	static glm::vec3 Evaluate(const glm::vec3* points, float t)
+	{
+		static_assert(Derivative <= Degree, "Derivative order exceeds the spline degree");
+		return Combine<Derivative>(points, t, std::make_index_sequence<PointsPerSegment>{});
+	}
+
+private:
+	template<size_t Derivative>
+	static constexpr BasisMatrix<Degree> MakeCoefficients()
+	{
+		BasisMatrix<Degree> m{};
+		for (size_t k = 0; k + Derivative <= Degree; k++)
+		{
+			float scale = SplineMath::Factorial(k + Derivative) / SplineMath::Factorial(k);
+			for (size_t j = 0; j < PointsPerSegment; j++)
+				m[k][j] = scale * Basis::Matrix[k + Derivative][j];
+		}
+		return m;
+	}
+
+	template<size_t Derivative, size_t... J>
+	static glm::vec3 Combine(const glm::vec3* points, float t, std::index_sequence<J...>)
+	{
+		using Powers = std::make_index_sequence<Degree - Derivative>;
+		return ((GetWeight<Derivative, J>(t, Powers{}) * points[J]) + ...);
+	}
+
+	// Horner's rule over the coefficients of control point J, from the highest power down
+	template<size_t Derivative, size_t J, size_t... K>
+	static float GetWeight(float t, std::index_sequence<K...>)
+	{
+		constexpr size_t Highest = Degree - Derivative;
+		float weight = s_Coefficients<Derivative>[Highest][J];
+		((weight = weight * t + s_Coefficients<Derivative>[Highest - 1 - K][J]), ...);
+		return weight;
+	}
+
+	template<size_t Derivative>
+	static constexpr BasisMatrix<Degree> s_Coefficients = MakeCoefficients<Derivative>();
+};
+
+using CubicBSpline = Spline<UniformBSplineBasis<3>>;
+using CubicBezier = Spline<BezierBasis<3>>;
+using CatmullRom = Spline<CatmullRomBasis<3>>;
+
+// The runtime matrix evaluation of the cubic uniform B-spline that Spline<Basis> replaced, kept as
+// the reference the spline benchmark checks and times the constexpr path against.
+namespace MatrixBSpline
+{
+template<size_t Derivative = 0>
+inline glm::vec3 Evaluate(const glm::vec3* points, float t)
+{
+	static_assert(Derivative <= 2, "Only the curve and its first two derivatives have matrices");
+
+	static const glm::mat4 m0{-1, 3, -3, 1, 3, -6, 0, 4, -3, 3, 3, 1, 1, 0, 0, 0};
+	static const glm::mat4x3 m1{-1, 2, -1, 3, -4, 0, -3, 2, 1, 1, 0, 0};
+	static const glm::mat4x2 m2{-1, 1, 3, -2, -3, 1, 1, 0};
+
+	glm::mat3x4 r(points[0][0], points[1][0], points[2][0], points[3][0], points[0][1],
+				  points[1][1], points[2][1], points[3][1], points[0][2], points[1][2],
+				  points[2][2], points[3][2]);
+	if constexpr (Derivative == 0)
+	{
+		glm::vec4 v = {t * t * t, t * t, t, 1};
+		return v * (1.f / 6) * m0 * r;
+	}
+	else if constexpr (Derivative == 1)
+	{
+		// m1 holds twice the derivative, the curve only ever used its direction
+		glm::vec3 v = {t * t, t, 1};
+		return v * 0.5f * m1 * r;
+	}
+	else
+	{
+		glm::vec2 v = {t, 1};
+		return v * m2 * r;
+	}
+}
+} // namespace MatrixBSpline
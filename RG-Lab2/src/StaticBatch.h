@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+#include "TextureCache.h"
+
+struct QuantizedVertex;
+
+// Binding point of the per-draw storage buffer, matches vertex_batch.glsl
+constexpr GLuint s_BatchDrawBinding = 1;
+
+// Location of a mesh inside the shared arenas
+struct BatchMesh
+{
+	int32_t baseVertex = 0;
+	uint32_t firstIndex = 0;
+};
+
+// std430 layout of one entry of the per-draw storage buffer. Submit fills in the texture arrays
+// and layers. A texture layer of -1 draws the solid color instead, a normal layer of -1 shades
+// with the vertex normals.
+struct BatchDrawData
+{
+	glm::mat4 model;
+	glm::vec4 positionScale;
+	glm::vec4 positionOffset;
+	glm::vec4 color;
+	int32_t textureLayer;
+	int32_t normalLayer;
+	int32_t textureArray;
+	int32_t normalArray;
+};
+static_assert(sizeof(BatchDrawData) == 128, "BatchDrawData must match the std430 layout");
+
+// Static geometry in one quantized vertex arena and one 32-bit index arena, textured from texture
+// arrays with one array per texture size and format, so textures are copied with their mip chains
+// instead of being rescaled. Draws sampling the same pair of arrays go out with one
+// glMultiDrawElementsIndirect, however many meshes and instances they cover. Per-draw data lives
+// in a storage buffer indexed by a draw id attribute that advances per instance, with every
+// command's base instance set to its index.
+class StaticBatch
+{
+public:
+	StaticBatch() = default;
+	~StaticBatch();
+
+	StaticBatch(const StaticBatch&) = delete;
+	StaticBatch& operator=(const StaticBatch&) = delete;
+
+	BatchMesh AddMesh(const QuantizedVertex* vertices, size_t vertexCount, const void* indices,
+					  size_t indexCount, size_t indexSize);
+	// Returns a handle for Submit, -1 for no texture. Textures may still be loading, they are
+	// copied into an array once uploaded and the batch lets go of them afterwards.
+	int32_t AddTexture(const std::shared_ptr<Texture>& texture);
+
+	// Queues one draw of indexCount indices starting firstIndex indices into the mesh. Textures
+	// are AddTexture handles, one that is not in an array yet is drawn as if there were none.
+	void Submit(const BatchMesh& mesh, uint32_t firstIndex, uint32_t indexCount,
+				const BatchDrawData& data, int32_t texture, int32_t normalTexture);
+	// Issues the queued draws with the currently bound program
+	void Draw();
+	// Deletes the arenas and texture arrays and empties the batch, handles and meshes handed out
+	// before are no longer valid. Runs in the destructor too, but the owner has to call it while
+	// the context is still current when the batch outlives the window.
+	void Release();
+
+	size_t GetDrawCount() const
+	{
+		return m_LastDrawCount;
+	}
+	size_t GetCallCount() const
+	{
+		return m_LastCallCount;
+	}
+	void PrintStatistics() const;
+
+private:
+	// Matches the layout glMultiDrawElementsIndirect reads
+	struct DrawElementsCommand
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+
+	// Every layer and level of one size and format
+	struct TextureArray
+	{
+		uint32_t id = 0;
+		GLenum internalFormat = GL_RGBA8;
+		GLsizei width = 0;
+		GLsizei height = 0;
+		GLsizei levels = 0;
+		GLsizei layerCount = 0;
+		GLsizei layerCapacity = 0;
+	};
+
+	// Texture behind an AddTexture handle, held until it has been copied into its array
+	struct Layer
+	{
+		std::shared_ptr<Texture> texture;
+		int32_t array = -1;
+		int32_t layer = -1;
+	};
+
+	// Grows a buffer to hold at least requiredCount elements, keeping the first count. Returns
+	// whether the buffer was replaced.
+	static bool Reserve(uint32_t& buffer, size_t& capacity, size_t count, size_t requiredCount,
+						size_t elementSize);
+	void SetupVertexArray();
+	void FillLayers();
+	int32_t FindArray(const Texture& texture);
+	void GrowArray(TextureArray& array);
+	size_t GetTextureMemory() const;
+
+private:
+	uint32_t m_VertexArray = 0;
+	uint32_t m_VertexBuffer = 0;
+	uint32_t m_IndexBuffer = 0;
+	uint32_t m_DrawIDBuffer = 0;
+	uint32_t m_DrawDataBuffer = 0;
+	uint32_t m_IndirectBuffer = 0;
+	size_t m_VertexCount = 0;
+	size_t m_VertexCapacity = 0;
+	size_t m_IndexCount = 0;
+	size_t m_IndexCapacity = 0;
+	size_t m_DrawIDCapacity = 0;
+
+	std::vector<TextureArray> m_TextureArrays{};
+	std::vector<Layer> m_Layers{};
+	// Keyed by texture name and format, so a texture loaded again after the cache released it
+	// maps to the layer it was copied into
+	std::unordered_map<std::string, int32_t> m_LayerIndices{};
+
+	std::vector<BatchDrawData> m_DrawData{};
+	std::vector<DrawElementsCommand> m_Commands{};
+	size_t m_LastDrawCount = 0;
+	size_t m_LastCallCount = 0;
+};
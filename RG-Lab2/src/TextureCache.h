@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "glad/glad.h"
+#include <glm/glm.hpp>
+
+class AssetLoader;
+
+enum class TextureFormat
+{
+	RGBA8,
+	SRGB8Alpha8
+};
+
+class Texture
+{
+public:
+	Texture(const std::string& name, TextureFormat format);
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	void Bind(uint32_t slot) const
+	{
+		glActiveTexture(GL_TEXTURE0 + slot);
+		glBindTexture(GL_TEXTURE_2D, m_ID);
+	}
+
+	uint32_t GetID() const
+	{
+		return m_ID;
+	}
+	const std::string& GetName() const
+	{
+		return m_Name;
+	}
+	TextureFormat GetFormat() const
+	{
+		return m_Format;
+	}
+	int GetWidth() const
+	{
+		return m_Width;
+	}
+	int GetHeight() const
+	{
+		return m_Height;
+	}
+	// Size of the texture and its mip chain on the GPU
+	size_t GetMemorySize() const;
+
+private:
+	friend class TextureCache;
+	void Upload(const unsigned char* pixels, int width, int height);
+
+private:
+	uint32_t m_ID{};
+	std::string m_Name;
+	TextureFormat m_Format;
+	int m_Width{};
+	int m_Height{};
+};
+
+// Process-wide cache of GL textures keyed by file path and format. Every file is decoded and
+// uploaded once and handed out as a shared handle; the cache keeps its own reference until
+// ReleaseUnused, so use counts above one are the live users. Only call it from the GL thread,
+// decoding of asynchronous requests happens on the AssetLoader workers. Clear must run before the
+// GL context is destroyed, static destruction would otherwise delete textures without one.
+class TextureCache
+{
+private:
+	TextureCache() = default;
+
+public:
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	static std::shared_ptr<Texture> Load(const std::string& path,
+										 TextureFormat format = TextureFormat::RGBA8,
+										 AssetLoader* loader = nullptr);
+	static std::shared_ptr<Texture> GetSolidColor(glm::u8vec4 color);
+
+	// Frees textures nobody but the cache holds, call it whenever their users are dropped
+	static void ReleaseUnused();
+	// Deletes every texture, handles still held elsewhere are left without a GL name
+	static void Clear();
+	static size_t GetMemoryUsage();
+	static void PrintStatistics();
+
+private:
+	static std::unordered_map<std::string, std::shared_ptr<Texture>> s_Textures;
+};
@@ -1,10 +1,16 @@
 #include <chrono>
 #include <time.h>
 
+#include "Benchmark.h"
 #include "Game.h"
+#include "Profiler.h"
 
-int main()
+int main(int argc, char** argv)
 {
+	BenchmarkSettings benchmarkSettings;
+	if (Benchmark::ParseArguments(argc, argv, benchmarkSettings))
+		return Benchmark::Run("Lab 2", benchmarkSettings);
+
 	srand((uint32_t)time(NULL));
 
 	Game::CreateGame("Lab 2", 2000, 1500);
@@ -14,9 +20,11 @@ int main()
 		auto currentTime = std::chrono::high_resolution_clock::now();
 		auto timeStep = currentTime - lastFrameTime;
 		lastFrameTime = currentTime;
+		Profiler::BeginFrame();
 		Game::Get().Update(
 			std::chrono::duration<float, std::chrono::milliseconds::period>(timeStep).count());
 		Game::Get().Render();
+		Profiler::EndFrame();
 	}
 	return 0;
 }
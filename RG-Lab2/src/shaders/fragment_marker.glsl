@@ -1,10 +0,0 @@
-#version 460
-
-layout(location = 0) out vec4 outColor;
-
-uniform vec3 color;
-
-void main()
-{
-    outColor = vec4(color, 1);
-}
@@ -0,0 +1,51 @@
+#version 450 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 norm;
+layout (location = 2) in vec2 texCoord;
+// Index of the draw, the base instance of its indirect command
+layout (location = 3) in uint drawID;
+
+layout (location = 0) out vec2 fragTexCoord;
+layout (location = 1) out vec3 fragNorm;
+layout (location = 2) out vec3 fragWorldPos;
+layout (location = 3) flat out int fragTextureLayer;
+layout (location = 4) flat out int fragNormalLayer;
+layout (location = 5) flat out vec4 fragColor;
+
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+};
+
+struct DrawData
+{
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+    vec4 color;
+    int textureLayer;
+    int normalLayer;
+    int textureArray;
+    int normalArray;
+};
+
+layout (std430, binding = 1) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+void main()
+{
+	DrawData draw = draws[drawID];
+	fragTexCoord = texCoord;
+	fragNorm = normalize((draw.model * vec4(norm, 0)).xyz);
+	vec4 worldPos = draw.model * vec4(pos * draw.positionScale.xyz + draw.positionOffset.xyz, 1);
+	fragWorldPos = worldPos.xyz;
+	fragTextureLayer = draw.textureLayer;
+	fragNormalLayer = draw.normalLayer;
+	fragColor = draw.color;
+	gl_Position = projection * view * worldPos;
+}
\ No newline at end of file
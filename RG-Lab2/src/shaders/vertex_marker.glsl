@@ -1,17 +0,0 @@
-#version 460
-
-layout (location = 0) in vec3 pos;
-
-layout(location = 0) out vec3 fragWorldPos;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    vec4 worldPos = vec4(pos, 1.0);
-    fragWorldPos = (worldPos).xyz;
-
-    gl_Position = projection * view * model * worldPos;
-}
\ No newline at end of file
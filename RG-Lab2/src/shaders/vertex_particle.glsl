@@ -1,4 +1,4 @@
-#version 460 core
+#version 450 core
 
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 texCoords;
@@ -9,8 +9,13 @@ layout (location = 0) out vec2 fragTexCoords;
 layout (location = 1) out vec3 fragPos;
 layout (location = 2) out vec3 fragParticleSystemCenter;
 
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+};
+
 uniform mat4 scale;
 uniform vec3 particleSystemCenter;
 
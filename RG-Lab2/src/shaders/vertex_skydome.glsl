@@ -1,16 +1,24 @@
-#version 460
+#version 450
 
 layout (location = 0) in vec3 pos;
 
 layout(location = 0) out vec3 fragWorldPos;
 
+layout (std140, binding = 0) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Dequantization of positions stored relative to the mesh bounds, identity for float meshes
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
 
 void main()
 {
-    vec4 worldPos = model * vec4(pos, 1.0);
+    vec4 worldPos = model * vec4(pos * positionScale + positionOffset, 1.0);
     fragWorldPos = (worldPos).xyz;
 
     gl_Position = projection * view * worldPos;
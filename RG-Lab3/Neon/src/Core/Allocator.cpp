@@ -2,7 +2,14 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "Allocator.h"
 
+#include "Renderer/UploadContext.h"
 #include "Renderer/VulkanRenderer.h"
+#include "Tools/PackedFloat.h"
+
+#include <execution>
+#include <fstream>
+
+#include <glm/gtc/packing.hpp>
 
 Neon::Allocator Neon::Allocator::s_Allocator;
 
@@ -23,26 +30,160 @@ Neon::TextureImage::~TextureImage()
 	Allocator::DestroyTextureImage(*this);
 }
 
-void Neon::Allocator::Init(vk::PhysicalDevice physicalDevice, vk::Device device)
+Neon::DynamicBuffer::DynamicBuffer(vk::DeviceSize sliceSize, uint32_t sliceCount,
+								   const vk::BufferUsageFlags& usage)
+	: m_SliceSize(sliceSize)
+	, m_SliceCount(sliceCount)
+{
+	vk::DeviceSize alignment = Allocator::GetMinBufferOffsetAlignment();
+	m_SliceStride = (sliceSize + alignment - 1) / alignment * alignment;
+	void* mappedData;
+	// Prefers device local memory the host can write to directly, when there is any
+	m_Buffer = Allocator::CreateMappedBuffer(m_SliceStride * sliceCount, usage, mappedData,
+											 VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Dynamic);
+	m_Data = static_cast<uint8_t*>(mappedData);
+}
+
+void Neon::Allocator::Init(vk::Instance instance, vk::PhysicalDevice physicalDevice,
+						   vk::Device device, bool memoryBudgetExtension)
 {
 	s_Allocator.m_PhysicalDevice = physicalDevice;
 	s_Allocator.m_LogicalDevice = device;
+	const auto& limits = physicalDevice.getProperties().limits;
+	s_Allocator.m_MinBufferOffsetAlignment = std::max(limits.minUniformBufferOffsetAlignment,
+													  limits.minStorageBufferOffsetAlignment);
 	VmaAllocatorCreateInfo allocatorInfo{{}, physicalDevice, device};
 	allocatorInfo.flags |= (uint32_t)VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT;
+	allocatorInfo.instance = instance;
+	if (memoryBudgetExtension)
+		allocatorInfo.flags |= (uint32_t)VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+	s_Allocator.m_MemoryBudgetExtension = memoryBudgetExtension;
 	vmaCreateAllocator(&allocatorInfo, &s_Allocator.m_Allocator);
+	s_Allocator.m_HdrTextureFormat = ChooseHdrTextureFormat();
+
+	void* ringData;
+	s_Allocator.m_StagingRing =
+		CreateMappedBuffer(s_StagingRingSize, vk::BufferUsageFlagBits::eTransferSrc, ringData,
+						   VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging);
+	s_Allocator.m_StagingRingData = static_cast<uint8_t*>(ringData);
+}
+
+void Neon::Allocator::Shutdown()
+{
+	s_Allocator.m_LogicalDevice.waitIdle();
+	s_Allocator.m_StagingSubmits.clear();
+	s_Allocator.m_StagingBuffers.clear();
+	s_Allocator.m_StagingRing.reset();
+	s_Allocator.m_StagingRingData = nullptr;
+}
+
+Neon::StagingAllocation Neon::Allocator::AllocateStaging(vk::DeviceSize size,
+														 vk::DeviceSize alignment)
+{
+	ReclaimStaging(false);
+	if (size <= s_StagingRingSize)
+	{
+		for (;;)
+		{
+			vk::DeviceSize head = s_Allocator.m_StagingHead;
+			vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+			if (offset + size > s_StagingRingSize)
+			{
+				// The rest of the ring is skipped and counted as used until this submission retires
+				offset = 0;
+				head -= s_StagingRingSize;
+			}
+			vk::DeviceSize consumed = offset + size - head;
+			if (s_Allocator.m_StagingUsed + consumed <= s_StagingRingSize)
+			{
+				s_Allocator.m_StagingHead = offset + size;
+				s_Allocator.m_StagingUsed += consumed;
+				s_Allocator.m_StagingOpen += consumed;
+				return {s_Allocator.m_StagingRing->m_Buffer, offset, size,
+						s_Allocator.m_StagingRingData + offset};
+			}
+			// Uploads that are still being recorded cannot be waited for
+			if (s_Allocator.m_StagingSubmits.empty()) break;
+			ReclaimStaging(true);
+		}
+	}
+
+	void* mappedData;
+	auto buffer = CreateMappedBuffer(size, vk::BufferUsageFlagBits::eTransferSrc, mappedData,
+									 VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging);
+	StagingAllocation allocation{buffer->m_Buffer, 0, size, mappedData};
+	s_Allocator.m_StagingBuffers.push_back(std::move(buffer));
+	return allocation;
 }
 
-void Neon::Allocator::FlushStaging()
+void Neon::Allocator::SubmitStaging(uint64_t ticket)
 {
+	if (s_Allocator.m_StagingOpen == 0 && s_Allocator.m_StagingBuffers.empty()) return;
+
+	s_Allocator.m_StagingSubmits.push_back(
+		{ticket, s_Allocator.m_StagingOpen, std::move(s_Allocator.m_StagingBuffers)});
 	s_Allocator.m_StagingBuffers.clear();
+	s_Allocator.m_StagingOpen = 0;
+}
+
+void Neon::Allocator::ReclaimStaging(bool wait)
+{
+	auto& submits = s_Allocator.m_StagingSubmits;
+	if (wait && !submits.empty()) UploadContext::Wait(submits.front().m_Ticket);
+	while (!submits.empty() && UploadContext::IsComplete(submits.front().m_Ticket))
+	{
+		s_Allocator.m_StagingUsed -= submits.front().m_Size;
+		submits.pop_front();
+	}
+	// Starting over at the beginning avoids wrapping around while the ring is empty
+	if (s_Allocator.m_StagingUsed == 0) s_Allocator.m_StagingHead = 0;
+}
+
+std::unique_ptr<Neon::BufferAllocation>
+Neon::Allocator::CreateMappedBuffer(const vk::DeviceSize& size, const vk::BufferUsageFlags& usage,
+									void*& mappedData, const VmaMemoryUsage& memoryUsage,
+									MemoryCategory category)
+{
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = memoryUsage;
+	allocInfo.flags =
+		VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+	allocInfo.requiredFlags =
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+	bufferInfo.size = size;
+	bufferInfo.usage = static_cast<VkBufferUsageFlags>(usage);
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	auto* bufferAllocation = new BufferAllocation();
+	VmaAllocationInfo allocationInfo{};
+	vmaCreateBuffer(s_Allocator.m_Allocator, &bufferInfo, &allocInfo, &bufferAllocation->m_Buffer,
+					&bufferAllocation->m_Allocation, &allocationInfo);
+	TrackAllocation(bufferAllocation->m_Allocation, category);
+	mappedData = allocationInfo.pMappedData;
+	return std::unique_ptr<BufferAllocation>(bufferAllocation);
+}
+
+std::unique_ptr<Neon::BufferAllocation>
+Neon::Allocator::CreateDeviceLocalBuffer(UploadContext& upload, const StagingAllocation& staging,
+										 const vk::BufferUsageFlags& usage)
+{
+	std::unique_ptr<BufferAllocation> resultBufferAllocation = CreateBuffer(
+		staging.m_Size, vk::BufferUsageFlagBits::eTransferDst | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+
+	vk::BufferCopy copyRegion{staging.m_Offset, 0, staging.m_Size};
+	upload.GetTransferCommandBuffer().copyBuffer(staging.m_Buffer, resultBufferAllocation->m_Buffer,
+												 1, &copyRegion);
+	upload.ReleaseBuffer(resultBufferAllocation->m_Buffer);
+	return std::move(resultBufferAllocation);
 }
 
 std::unique_ptr<Neon::BufferAllocation>
 Neon::Allocator::CreateBuffer(const vk::DeviceSize& size, const vk::BufferUsageFlags& usage,
-							  const VmaMemoryUsage& memoryUsage)
+							  const VmaMemoryUsage& memoryUsage, MemoryCategory category)
 {
 	VmaAllocationCreateInfo allocInfo = {};
 	allocInfo.usage = memoryUsage;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
 	VkBufferCreateInfo bufferInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
 	bufferInfo.size = size;
 	bufferInfo.usage = static_cast<VkBufferUsageFlags>(usage);
@@ -50,22 +191,24 @@ Neon::Allocator::CreateBuffer(const vk::DeviceSize& size, const vk::BufferUsageF
 	auto* bufferAllocation = new BufferAllocation();
 	vmaCreateBuffer(s_Allocator.m_Allocator, &bufferInfo, &allocInfo, &bufferAllocation->m_Buffer,
 					&bufferAllocation->m_Allocation, nullptr);
+	TrackAllocation(bufferAllocation->m_Allocation, category);
 	return std::unique_ptr<BufferAllocation>(bufferAllocation);
 }
 
 std::unique_ptr<Neon::ImageAllocation>
-Neon::Allocator::CreateImage(const uint32_t width, const uint32_t height,
+Neon::Allocator::CreateImage(const uint32_t width, const uint32_t height, uint32_t mipLevels,
 							 const vk::SampleCountFlagBits& sampleCount, const vk::Format& format,
 							 const vk::ImageTiling& tiling, const vk::ImageUsageFlags& usage,
-							 const VmaMemoryUsage& memoryUsage)
+							 const VmaMemoryUsage& memoryUsage, MemoryCategory category)
 {
 	VmaAllocationCreateInfo allocInfo = {};
 	allocInfo.usage = memoryUsage;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
 	VkImageCreateInfo imageInfo = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
 	imageInfo.format = static_cast<VkFormat>(format);
 	imageInfo.extent = {width, height, 1};
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.samples = static_cast<VkSampleCountFlagBits>(sampleCount);
 	imageInfo.tiling = static_cast<VkImageTiling>(tiling);
@@ -76,13 +219,15 @@ Neon::Allocator::CreateImage(const uint32_t width, const uint32_t height,
 	auto imageAllocation = new ImageAllocation();
 	vmaCreateImage(s_Allocator.m_Allocator, &imageInfo, &allocInfo, &imageAllocation->m_Image,
 				   &imageAllocation->m_Allocation, nullptr);
+	TrackAllocation(imageAllocation->m_Allocation, category);
 	return std::unique_ptr<ImageAllocation>(imageAllocation);
 }
 
-void Neon::Allocator::TransitionImageLayout(vk::Image image, vk::ImageAspectFlagBits aspect,
+void Neon::Allocator::TransitionImageLayout(const vk::CommandBuffer& commandBuffer, vk::Image image,
+											vk::ImageAspectFlagBits aspect,
 											vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
 {
-	vk::ImageSubresourceRange imgSubresourceRange{aspect, 0, 1, 0, 1};
+	vk::ImageSubresourceRange imgSubresourceRange{aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1};
 	vk::ImageMemoryBarrier barrier{{},
 								   {},
 								   oldLayout,
@@ -151,13 +296,12 @@ void Neon::Allocator::TransitionImageLayout(vk::Image image, vk::ImageAspectFlag
 	{
 		assert(false);
 	}
-	auto commandBuffer = VulkanRenderer::BeginSingleTimeCommands();
 	commandBuffer.pipelineBarrier(sourceStage, destinationStage, {}, {}, {}, {barrier});
-	VulkanRenderer::EndSingleTimeCommands(commandBuffer);
 }
 
 std::unique_ptr<Neon::ImageAllocation>
-Neon::Allocator::CreateTextureImage(const std::string& filename)
+Neon::Allocator::CreateTextureImage(UploadContext& upload, const std::string& filename,
+									vk::Format format)
 {
 	int texWidth, texHeight, texChannels;
 	stbi_uc* pixels =
@@ -171,108 +315,321 @@ Neon::Allocator::CreateTextureImage(const std::string& filename)
 		pixels = reinterpret_cast<stbi_uc*>(color);
 	}
 
-	return CreateTextureImage(pixels, texWidth, texHeight);
+	return CreateTextureImage(upload, pixels, texWidth, texHeight, format);
 }
 
 std::unique_ptr<Neon::ImageAllocation>
-Neon::Allocator::CreateTextureImage(stbi_uc* pixels, int texWidth, int texHeight)
+Neon::Allocator::CreateTextureImage(UploadContext& upload, stbi_uc* pixels, int texWidth,
+									int texHeight, vk::Format format)
 {
 	vk::DeviceSize imageSize =
 		static_cast<uint64_t>(texWidth) * static_cast<uint64_t>(texHeight) * sizeof(glm::u8vec4);
 
-	std::unique_ptr<BufferAllocation> stagingBufferAllocation =
-		CreateBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	StagingAllocation staging = AllocateStaging(imageSize, sizeof(glm::u8vec4));
+	memcpy(staging.m_Data, pixels, static_cast<size_t>(imageSize));
+	stbi_image_free(pixels);
 
-	void* mappedData;
-	vmaMapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation, &mappedData);
-	memcpy(mappedData, pixels, static_cast<size_t>(imageSize));
-	vmaUnmapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation);
+	return CreateSampledImage(upload, staging, texWidth, texHeight, format);
+}
 
+std::unique_ptr<Neon::ImageAllocation>
+Neon::Allocator::CreateHdrTextureImage(UploadContext& upload, const std::string& filename)
+{
+	int texWidth, texHeight, nrComponents;
+	float* pixels = stbi_loadf(filename.c_str(), &texWidth, &texHeight, &nrComponents, 3);
+	assert(pixels);
+
+	// Every supported format packs a texel into 4 or 8 bytes, converted straight into staging. The
+	// conversion is a parallel loop over scalar encoders, not a SIMD batch conversion; the packed
+	// formats use Neon's encoders since glm 0.9.9.7 mis-encodes denormals and clamps too early.
+	const vk::Format format = s_Allocator.m_HdrTextureFormat;
+	const size_t texelCount = static_cast<size_t>(texWidth) * static_cast<size_t>(texHeight);
+	const auto* source = reinterpret_cast<const glm::vec3*>(pixels);
+	StagingAllocation staging;
+	if (format == vk::Format::eR16G16B16A16Sfloat)
+	{
+		staging = AllocateStaging(texelCount * sizeof(uint64_t), sizeof(uint64_t));
+		std::transform(std::execution::par_unseq, source, source + texelCount,
+					   staging.As<uint64_t>(),
+					   [](const glm::vec3& color) {
+						   // Past the largest half the value would turn into infinity
+						   return glm::packHalf4x16({glm::min(color, glm::vec3(65504.0f)), 1.0f});
+					   });
+	}
+	else if (format == vk::Format::eE5B9G9R9UfloatPack32)
+	{
+		staging = AllocateStaging(texelCount * sizeof(uint32_t), sizeof(uint32_t));
+		std::transform(std::execution::par_unseq, source, source + texelCount,
+					   staging.As<uint32_t>(),
+					   [](const glm::vec3& color) { return PackE5B9G9R9(color); });
+	}
+	else
+	{
+		assert(format == vk::Format::eB10G11R11UfloatPack32);
+		staging = AllocateStaging(texelCount * sizeof(uint32_t), sizeof(uint32_t));
+		std::transform(std::execution::par_unseq, source, source + texelCount,
+					   staging.As<uint32_t>(),
+					   [](const glm::vec3& color) { return PackB10G11R11(color); });
+	}
 	stbi_image_free(pixels);
 
+	return CreateSampledImage(upload, staging, texWidth, texHeight, format);
+}
+
+std::unique_ptr<Neon::ImageAllocation>
+Neon::Allocator::CreateSampledImage(UploadContext& upload, const StagingAllocation& staging,
+									int width, int height, vk::Format format)
+{
+	uint32_t mipLevels = 1;
+	if (SupportsLinearBlit(format))
+		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
 	std::unique_ptr<ImageAllocation> imageAllocation =
-		CreateImage(texWidth, texHeight, vk::SampleCountFlagBits::e1, vk::Format::eR8G8B8A8Srgb,
+		CreateImage(width, height, mipLevels, vk::SampleCountFlagBits::e1, format,
 					vk::ImageTiling::eOptimal,
-					vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-					VMA_MEMORY_USAGE_GPU_ONLY);
-
-	TransitionImageLayout(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
-						  vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+					vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
+						vk::ImageUsageFlagBits::eSampled,
+					VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Texture);
 
 	vk::ImageSubresourceLayers imgSubresourceLayers{vk::ImageAspectFlagBits::eColor, 0, 0, 1};
 	vk::BufferImageCopy region{
-		0,
+		staging.m_Offset,
 		0,
 		0,
 		imgSubresourceLayers,
 		{0, 0, 0},
-		vk::Extent3D{static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1}};
+		vk::Extent3D{static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1}};
 
-	auto commandBuffer = VulkanRenderer::BeginSingleTimeCommands();
-	commandBuffer.copyBufferToImage(stagingBufferAllocation->m_Buffer, imageAllocation->m_Image,
+	auto commandBuffer = upload.GetTransferCommandBuffer();
+	TransitionImageLayout(commandBuffer, imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
+						  vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+	commandBuffer.copyBufferToImage(staging.m_Buffer, imageAllocation->m_Image,
 									vk::ImageLayout::eTransferDstOptimal, {region});
-	VulkanRenderer::EndSingleTimeCommands(commandBuffer);
+	if (mipLevels == 1)
+	{
+		upload.ReleaseImage(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
+							vk::ImageLayout::eShaderReadOnlyOptimal);
+		return std::move(imageAllocation);
+	}
 
-	TransitionImageLayout(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
-						  vk::ImageLayout::eTransferDstOptimal,
-						  vk::ImageLayout::eShaderReadOnlyOptimal);
+	// Blits are not supported on transfer queues, the graphics queue gets the image as it is
+	upload.ReleaseImage(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
+						vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits::eTransfer,
+						vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite);
+	GenerateMipmaps(upload.GetGraphicsCommandBuffer(), imageAllocation->m_Image, width, height,
+					mipLevels);
 
-	s_Allocator.m_StagingBuffers.push_back(std::move(stagingBufferAllocation));
 	return std::move(imageAllocation);
 }
 
-std::unique_ptr<Neon::ImageAllocation>
-Neon::Allocator::CreateHdrTextureImage(const std::string& filename)
+bool Neon::Allocator::SupportsLinearBlit(vk::Format format)
 {
-	int texWidth, texHeight, nrComponents;
-	float* pixels = stbi_loadf(filename.c_str(), &texWidth, &texHeight, &nrComponents, 0);
+	const vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eBlitSrc |
+											vk::FormatFeatureFlagBits::eBlitDst |
+											vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+	auto properties = s_Allocator.m_PhysicalDevice.getFormatProperties(format);
+	return (properties.optimalTilingFeatures & required) == required;
+}
 
-	vk::DeviceSize imageSize =
-		static_cast<uint64_t>(texWidth) * static_cast<uint64_t>(texHeight) * sizeof(float) * 3;
+vk::Format Neon::Allocator::ChooseHdrTextureFormat()
+{
+	// The packed formats take 4 bytes per texel. R16G16B16A16Sfloat takes 8 and is required to
+	// support filtering and blits, so it is the fallback.
+	for (vk::Format format : {vk::Format::eB10G11R11UfloatPack32,
+							  vk::Format::eE5B9G9R9UfloatPack32, vk::Format::eR16G16B16A16Sfloat})
+	{
+		if (SupportsLinearBlit(format)) return format;
+	}
+	return vk::Format::eR16G16B16A16Sfloat;
+}
 
-	std::unique_ptr<BufferAllocation> stagingBufferAllocation =
-		CreateBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_GPU_TO_CPU);
+void Neon::Allocator::GenerateMipmaps(const vk::CommandBuffer& commandBuffer, vk::Image image,
+									  int32_t width, int32_t height, uint32_t mipLevels)
+{
+	vk::ImageMemoryBarrier barrier{vk::AccessFlagBits::eTransferWrite,
+								   vk::AccessFlagBits::eTransferRead,
+								   vk::ImageLayout::eTransferDstOptimal,
+								   vk::ImageLayout::eTransferSrcOptimal,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   image,
+								   {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}};
+	for (uint32_t level = 1; level < mipLevels; level++)
+	{
+		// The previous level was written by the copy or the last blit, it becomes the source
+		barrier.subresourceRange.baseMipLevel = level - 1;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+									  vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, {barrier});
+
+		int32_t levelWidth = std::max(width / 2, 1);
+		int32_t levelHeight = std::max(height / 2, 1);
+		vk::ImageBlit blit{
+			{vk::ImageAspectFlagBits::eColor, level - 1, 0, 1},
+			{vk::Offset3D{0, 0, 0}, vk::Offset3D{width, height, 1}},
+			{vk::ImageAspectFlagBits::eColor, level, 0, 1},
+			{vk::Offset3D{0, 0, 0}, vk::Offset3D{levelWidth, levelHeight, 1}}};
+		commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image,
+								vk::ImageLayout::eTransferDstOptimal, {blit}, vk::Filter::eLinear);
+		width = levelWidth;
+		height = levelHeight;
+	}
 
-	void* mappedData;
-	vmaMapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation, &mappedData);
-	memcpy(mappedData, pixels, static_cast<size_t>(imageSize));
-	vmaUnmapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation);
+	// Every level but the last one was a blit source
+	vk::ImageMemoryBarrier sources{vk::AccessFlagBits::eTransferRead,
+								   vk::AccessFlagBits::eShaderRead,
+								   vk::ImageLayout::eTransferSrcOptimal,
+								   vk::ImageLayout::eShaderReadOnlyOptimal,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   image,
+								   {vk::ImageAspectFlagBits::eColor, 0, mipLevels - 1, 0, 1}};
+	vk::ImageMemoryBarrier last{vk::AccessFlagBits::eTransferWrite,
+								vk::AccessFlagBits::eShaderRead,
+								vk::ImageLayout::eTransferDstOptimal,
+								vk::ImageLayout::eShaderReadOnlyOptimal,
+								VK_QUEUE_FAMILY_IGNORED,
+								VK_QUEUE_FAMILY_IGNORED,
+								image,
+								{vk::ImageAspectFlagBits::eColor, mipLevels - 1, 1, 0, 1}};
+	commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+								  vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {},
+								  {sources, last});
+}
 
-	stbi_image_free(pixels);
+bool Neon::Allocator::IsLazilyAllocatedMemorySupported()
+{
+	const VkPhysicalDeviceMemoryProperties* memoryProperties;
+	vmaGetMemoryProperties(s_Allocator.m_Allocator, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; i++)
+	{
+		if (memoryProperties->memoryTypes[i].propertyFlags &
+			VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+			return true;
+	}
+	return false;
+}
 
-	std::unique_ptr<ImageAllocation> imageAllocation =
-		CreateImage(texWidth, texHeight, vk::SampleCountFlagBits::e1, vk::Format::eR32G32B32Sfloat,
-					vk::ImageTiling::eLinear,
-					vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-					VMA_MEMORY_USAGE_GPU_ONLY);
+const char* Neon::Allocator::GetCategoryName(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::RenderTarget: return "RenderTargets";
+	case MemoryCategory::MsaaTarget: return "MsaaTargets";
+	case MemoryCategory::Texture: return "Textures";
+	case MemoryCategory::Mesh: return "Meshes";
+	case MemoryCategory::Staging: return "Staging";
+	case MemoryCategory::Dynamic: return "DynamicBuffers";
+	default: return "Other";
+	}
+}
 
-	TransitionImageLayout(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
-						  vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
+Neon::MemoryStatistics Neon::Allocator::GetMemoryStatistics()
+{
+	MemoryStatistics statistics{};
+	statistics.m_Categories = s_Allocator.m_CategoryStatistics;
+	statistics.m_MemoryBudgetExtension = s_Allocator.m_MemoryBudgetExtension;
+
+	const VkPhysicalDeviceMemoryProperties* memoryProperties;
+	vmaGetMemoryProperties(s_Allocator.m_Allocator, &memoryProperties);
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetBudget(s_Allocator.m_Allocator, budgets);
+	for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+	{
+		const VkMemoryHeap& heap = memoryProperties->memoryHeaps[i];
+		statistics.m_Heaps.push_back({heap.size,
+									  (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+									  budgets[i].blockBytes, budgets[i].allocationBytes,
+									  budgets[i].usage, budgets[i].budget});
+	}
 
-	vk::ImageSubresourceLayers imgSubresourceLayers{vk::ImageAspectFlagBits::eColor, 0, 0, 1};
-	vk::BufferImageCopy region{
-		0,
-		0,
-		0,
-		imgSubresourceLayers,
-		{0, 0, 0},
-		vk::Extent3D{static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1}};
+	statistics.m_StagingRingUsed = s_Allocator.m_StagingUsed;
+	statistics.m_StagingRingSize = s_Allocator.m_StagingRing ? s_StagingRingSize : 0;
+	statistics.m_PendingStagingSubmits = static_cast<uint32_t>(s_Allocator.m_StagingSubmits.size());
+	statistics.m_OpenStagingBuffers = static_cast<uint32_t>(s_Allocator.m_StagingBuffers.size());
+	return statistics;
+}
 
-	auto commandBuffer = VulkanRenderer::BeginSingleTimeCommands();
-	commandBuffer.copyBufferToImage(stagingBufferAllocation->m_Buffer, imageAllocation->m_Image,
-									vk::ImageLayout::eTransferDstOptimal, {region});
-	VulkanRenderer::EndSingleTimeCommands(commandBuffer);
+std::string Neon::Allocator::BuildStatisticsJson()
+{
+	MemoryStatistics statistics = GetMemoryStatistics();
+	std::stringstream json;
+	json << "{\n  \"Categories\": {";
+	for (size_t i = 0; i < statistics.m_Categories.size(); i++)
+	{
+		json << (i ? "," : "") << "\n    \""
+			 << GetCategoryName(static_cast<MemoryCategory>(i)) << "\": {\"Allocations\": "
+			 << statistics.m_Categories[i].m_AllocationCount
+			 << ", \"Bytes\": " << statistics.m_Categories[i].m_Bytes << "}";
+	}
+	json << "\n  },\n  \"MemoryBudgetExtension\": "
+		 << (statistics.m_MemoryBudgetExtension ? "true" : "false") << ",\n  \"Heaps\": [";
+	for (size_t i = 0; i < statistics.m_Heaps.size(); i++)
+	{
+		const MemoryHeapStatistics& heap = statistics.m_Heaps[i];
+		json << (i ? "," : "") << "\n    {\"Size\": " << heap.m_Size
+			 << ", \"DeviceLocal\": " << (heap.m_DeviceLocal ? "true" : "false")
+			 << ", \"BlockBytes\": " << heap.m_BlockBytes
+			 << ", \"AllocationBytes\": " << heap.m_AllocationBytes
+			 << ", \"Usage\": " << heap.m_Usage << ", \"Budget\": " << heap.m_Budget << "}";
+	}
+	json << "\n  ],\n  \"Staging\": {\"RingUsed\": " << statistics.m_StagingRingUsed
+		 << ", \"RingSize\": " << statistics.m_StagingRingSize
+		 << ", \"PendingSubmits\": " << statistics.m_PendingStagingSubmits
+		 << ", \"OpenBuffers\": " << statistics.m_OpenStagingBuffers << "},\n";
+	// Dumps taken with different render target settings can be told apart and compared
+	const RenderTargetSettings& targets = VulkanRenderer::GetRenderTargetSettings();
+	json << "  \"RenderTargets\": {\"ColorFormat\": \"" << vk::to_string(targets.m_ColorFormat)
+		 << "\", \"DepthFormat\": \"" << vk::to_string(targets.m_DepthFormat)
+		 << "\", \"Samples\": " << static_cast<uint32_t>(targets.m_Samples)
+		 << ", \"LazilyAllocated\": "
+		 << (VulkanRenderer::AreMsaaTargetsLazilyAllocated() ? "true" : "false")
+		 << "},\n  \"Vma\": ";
+
+	char* vmaStatistics;
+	vmaBuildStatsString(s_Allocator.m_Allocator, &vmaStatistics, VK_TRUE);
+	json << vmaStatistics << "\n}\n";
+	vmaFreeStatsString(s_Allocator.m_Allocator, vmaStatistics);
+	return json.str();
+}
 
-	TransitionImageLayout(imageAllocation->m_Image, vk::ImageAspectFlagBits::eColor,
-						  vk::ImageLayout::eTransferDstOptimal,
-						  vk::ImageLayout::eShaderReadOnlyOptimal);
+void Neon::Allocator::DumpStatistics(const std::string& filename)
+{
+	std::ofstream file(filename);
+	assert(file.is_open());
+	file << BuildStatisticsJson();
+}
 
-	s_Allocator.m_StagingBuffers.push_back(std::move(stagingBufferAllocation));
-	return std::move(imageAllocation);
+void Neon::Allocator::TrackAllocation(VmaAllocation allocation, MemoryCategory category)
+{
+	assert(category < MemoryCategory::Count);
+	// Allocations are created with VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT, so the name
+	// shows up in the detailed statistics and identifies the category again when it is freed
+	vmaSetAllocationUserData(s_Allocator.m_Allocator, allocation,
+							 const_cast<char*>(GetCategoryName(category)));
+	VmaAllocationInfo allocationInfo;
+	vmaGetAllocationInfo(s_Allocator.m_Allocator, allocation, &allocationInfo);
+	auto& statistics = s_Allocator.m_CategoryStatistics[static_cast<size_t>(category)];
+	statistics.m_AllocationCount++;
+	statistics.m_Bytes += allocationInfo.size;
 }
 
 void Neon::Allocator::FreeMemory(VmaAllocation allocation)
 {
+	if (allocation)
+	{
+		VmaAllocationInfo allocationInfo;
+		vmaGetAllocationInfo(s_Allocator.m_Allocator, allocation, &allocationInfo);
+		const char* name = static_cast<const char*>(allocationInfo.pUserData);
+		for (size_t i = 0; name && i < s_Allocator.m_CategoryStatistics.size(); i++)
+		{
+			if (strcmp(name, GetCategoryName(static_cast<MemoryCategory>(i))) == 0)
+			{
+				s_Allocator.m_CategoryStatistics[i].m_AllocationCount--;
+				s_Allocator.m_CategoryStatistics[i].m_Bytes -= allocationInfo.size;
+				break;
+			}
+		}
+	}
 	vmaFreeMemory(s_Allocator.m_Allocator, allocation);
 }
 
@@ -290,6 +647,6 @@ void Neon::Allocator::DestroyBufferAllocation(Neon::BufferAllocation& bufferAllo
 
 void Neon::Allocator::DestroyTextureImage(Neon::TextureImage& textureImage)
 {
-	s_Allocator.m_LogicalDevice.destroySampler(textureImage.m_Descriptor.sampler);
+	// The sampler belongs to SamplerCache
 	s_Allocator.m_LogicalDevice.destroyImageView(textureImage.m_Descriptor.imageView);
 }
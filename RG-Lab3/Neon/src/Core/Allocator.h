@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <queue>
 
 #include <vk_mem_alloc.h>
@@ -9,6 +10,50 @@
 
 namespace Neon
 {
+class UploadContext;
+// What an allocation is used for, memory statistics are broken down by it
+enum class MemoryCategory : uint32_t
+{
+	RenderTarget,
+	// Multisampled attachments that are resolved within the render pass, lazily allocated
+	// where the device supports it, in which case the bytes are reserved but may never be backed
+	MsaaTarget,
+	Texture,
+	Mesh,
+	Staging,
+	Dynamic,
+	Other,
+	Count
+};
+struct MemoryCategoryStatistics
+{
+	uint32_t m_AllocationCount = 0;
+	vk::DeviceSize m_Bytes = 0;
+};
+struct MemoryHeapStatistics
+{
+	vk::DeviceSize m_Size = 0;
+	bool m_DeviceLocal = false;
+	// Bytes of device memory blocks and of the allocations placed in them
+	vk::DeviceSize m_BlockBytes = 0;
+	vk::DeviceSize m_AllocationBytes = 0;
+	// Usage of the whole process and what is available to it, reported by the driver when
+	// VK_EXT_memory_budget is enabled and estimated by VMA otherwise
+	vk::DeviceSize m_Usage = 0;
+	vk::DeviceSize m_Budget = 0;
+};
+struct MemoryStatistics
+{
+	std::array<MemoryCategoryStatistics, static_cast<size_t>(MemoryCategory::Count)> m_Categories{};
+	std::vector<MemoryHeapStatistics> m_Heaps;
+	bool m_MemoryBudgetExtension = false;
+	vk::DeviceSize m_StagingRingUsed = 0;
+	vk::DeviceSize m_StagingRingSize = 0;
+	// Submitted uploads whose staging memory is not reclaimed yet
+	uint32_t m_PendingStagingSubmits = 0;
+	// Dedicated staging buffers of uploads that were never submitted
+	uint32_t m_OpenStagingBuffers = 0;
+};
 struct BufferAllocation
 {
 	~BufferAllocation();
@@ -45,6 +90,76 @@ struct TextureImage
 	vk::DescriptorImageInfo m_Descriptor{};
 	std::unique_ptr<ImageAllocation> m_TextureAllocation{};
 };
+// Upload space handed out by Allocator::AllocateStaging. m_Data is the mapped memory at m_Offset
+// within m_Buffer; it stays valid until the copy reading it has been submitted and completed.
+struct StagingAllocation
+{
+	vk::Buffer m_Buffer{};
+	vk::DeviceSize m_Offset = 0;
+	vk::DeviceSize m_Size = 0;
+	void* m_Data = nullptr;
+
+	template<typename T>
+	[[nodiscard]] T* As() const
+	{
+		return static_cast<T*>(m_Data);
+	}
+};
+// View of count elements at data, for writing straight into mapped memory
+template<typename T>
+struct Span
+{
+	T* m_Data = nullptr;
+	size_t m_Size = 0;
+
+	T& operator[](size_t index) const
+	{
+		assert(index < m_Size);
+		return m_Data[index];
+	}
+	[[nodiscard]] size_t size() const
+	{
+		return m_Size;
+	}
+	T* begin() const
+	{
+		return m_Data;
+	}
+	T* end() const
+	{
+		return m_Data + m_Size;
+	}
+};
+// Buffer for data rewritten every frame. It is mapped once at creation and split into one slice
+// per frame, so the CPU fills the slice of the frame being recorded while the GPU may still read
+// the others. The memory is host coherent, writes are plain stores without flushes.
+class DynamicBuffer
+{
+public:
+	DynamicBuffer() = default;
+	DynamicBuffer(vk::DeviceSize sliceSize, uint32_t sliceCount, const vk::BufferUsageFlags& usage);
+
+	template<typename T>
+	[[nodiscard]] Span<T> GetSlice(uint32_t slice) const
+	{
+		assert(slice < m_SliceCount);
+		return {reinterpret_cast<T*>(m_Data + slice * m_SliceStride),
+				static_cast<size_t>(m_SliceSize / sizeof(T))};
+	}
+	[[nodiscard]] vk::DescriptorBufferInfo GetDescriptor(uint32_t slice) const
+	{
+		assert(slice < m_SliceCount);
+		return {m_Buffer->m_Buffer, slice * m_SliceStride, m_SliceSize};
+	}
+
+private:
+	std::unique_ptr<BufferAllocation> m_Buffer{};
+	uint8_t* m_Data = nullptr;
+	vk::DeviceSize m_SliceSize = 0;
+	// Slice size rounded up to the buffer offset alignment of descriptors
+	vk::DeviceSize m_SliceStride = 0;
+	uint32_t m_SliceCount = 0;
+};
 class Allocator
 {
 public:
@@ -53,25 +168,58 @@ public:
 	Allocator& operator=(const Allocator&) = delete;
 	Allocator& operator=(Allocator&&) = delete;
 
-	static void Init(vk::PhysicalDevice physicalDevice, vk::Device device);
-	static void FlushStaging();
-	static std::unique_ptr<BufferAllocation> CreateBuffer(const vk::DeviceSize& size,
-														  const vk::BufferUsageFlags& usage,
-														  const VmaMemoryUsage& memoryUsage);
+	static void Init(vk::Instance instance, vk::PhysicalDevice physicalDevice, vk::Device device,
+					 bool memoryBudgetExtension);
+	static void Shutdown();
+
+	// Sub-allocates upload space from the persistently mapped staging ring, waiting for the oldest
+	// submitted uploads when it is full. Requests that cannot fit get a buffer of their own. Copies
+	// from the space must be recorded into the next UploadContext submission.
+	static StagingAllocation AllocateStaging(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+	// Everything allocated since the previous call is recycled once the upload ticket completes
+	static void SubmitStaging(uint64_t ticket);
+
+	// Host coherent buffer that stays mapped until it is destroyed
+	static std::unique_ptr<BufferAllocation>
+	CreateMappedBuffer(const vk::DeviceSize& size, const vk::BufferUsageFlags& usage,
+					   void*& mappedData,
+					   const VmaMemoryUsage& memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
+					   MemoryCategory category = MemoryCategory::Other);
+	static std::unique_ptr<BufferAllocation>
+	CreateBuffer(const vk::DeviceSize& size, const vk::BufferUsageFlags& usage,
+				 const VmaMemoryUsage& memoryUsage,
+				 MemoryCategory category = MemoryCategory::Other);
 
 	static std::unique_ptr<ImageAllocation>
-	CreateImage(uint32_t width, uint32_t height, const vk::SampleCountFlagBits& sampleCount,
+	CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels,
+				const vk::SampleCountFlagBits& sampleCount,
 				const vk::Format& format, const vk::ImageTiling& tiling,
-				const vk::ImageUsageFlags& usage, const VmaMemoryUsage& memoryUsage);
+				const vk::ImageUsageFlags& usage, const VmaMemoryUsage& memoryUsage,
+				MemoryCategory category = MemoryCategory::Other);
 
-	static void TransitionImageLayout(vk::Image image, vk::ImageAspectFlagBits aspect,
-									  vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+	// Transitions every mip level of the image
+	static void TransitionImageLayout(const vk::CommandBuffer& commandBuffer, vk::Image image,
+									  vk::ImageAspectFlagBits aspect, vk::ImageLayout oldLayout,
+									  vk::ImageLayout newLayout);
 
-	static std::unique_ptr<ImageAllocation> CreateTextureImage(const std::string& filename);
-	static std::unique_ptr<ImageAllocation> CreateTextureImage(stbi_uc* pixels, int texWidth,
-															   int texHeight);
+	// Format has to be an 8 bit RGBA one, sRGB for colors and UNORM for data such as normal maps
+	static std::unique_ptr<ImageAllocation>
+	CreateTextureImage(UploadContext& upload, const std::string& filename,
+					   vk::Format format = vk::Format::eR8G8B8A8Srgb);
+	// Creates the full mip chain when the format can be blitted with linear filtering. Level 0 is
+	// copied on the transfer queue, the other levels are blitted on the graphics queue.
+	static std::unique_ptr<ImageAllocation>
+	CreateTextureImage(UploadContext& upload, stbi_uc* pixels, int texWidth, int texHeight,
+					   vk::Format format = vk::Format::eR8G8B8A8Srgb);
 
-	static std::unique_ptr<ImageAllocation> CreateHdrTextureImage(const std::string& filename);
+	// Converts the RGB floats to the format returned by GetHdrTextureFormat, with a mip chain
+	static std::unique_ptr<ImageAllocation> CreateHdrTextureImage(UploadContext& upload,
+																  const std::string& filename);
+	// Most compact HDR format the device can filter and blit, views of HDR textures need it
+	[[nodiscard]] static vk::Format GetHdrTextureFormat()
+	{
+		return s_Allocator.m_HdrTextureFormat;
+	}
 
 	template<typename T>
 	static void UpdateAllocation(const VmaAllocation& allocation, const T& data)
@@ -93,30 +241,38 @@ public:
 
 	template<typename T>
 	static std::unique_ptr<BufferAllocation>
-	CreateDeviceLocalBuffer(const vk::CommandBuffer& commandBuffer, const std::vector<T>& data,
+	CreateDeviceLocalBuffer(UploadContext& upload, const std::vector<T>& data,
 							const vk::BufferUsageFlags& usage)
 	{
 		vk::DeviceSize bufferSize = sizeof(data[0]) * data.size();
+		StagingAllocation staging = AllocateStaging(bufferSize);
+		memcpy(staging.m_Data, data.data(), (size_t)bufferSize);
+		return CreateDeviceLocalBuffer(upload, staging, usage);
+	}
 
-		std::unique_ptr<BufferAllocation> stagingBufferAllocation = CreateBuffer(
-			bufferSize, vk::BufferUsageFlagBits::eTransferSrc, VMA_MEMORY_USAGE_GPU_TO_CPU);
-
-		void* mappedData;
-		vmaMapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation, &mappedData);
-		memcpy(mappedData, data.data(), (size_t)bufferSize);
-		vmaUnmapMemory(s_Allocator.m_Allocator, stagingBufferAllocation->m_Allocation);
-
-		std::unique_ptr<BufferAllocation> resultBufferAllocation = CreateBuffer(
-			bufferSize, vk::BufferUsageFlagBits::eTransferDst | usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	// Records a copy of data already written to staging memory into a new device local buffer
+	static std::unique_ptr<BufferAllocation>
+	CreateDeviceLocalBuffer(UploadContext& upload, const StagingAllocation& staging,
+							const vk::BufferUsageFlags& usage);
 
-		vk::BufferCopy copyRegion{0, 0, bufferSize};
+	// Whether a memory type with VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT exists, which transient
+	// attachments can be created in with VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED
+	[[nodiscard]] static bool IsLazilyAllocatedMemorySupported();
 
-		commandBuffer.copyBuffer(stagingBufferAllocation->m_Buffer,
-								 resultBufferAllocation->m_Buffer, 1, &copyRegion);
-		s_Allocator.m_StagingBuffers.push_back(std::move(stagingBufferAllocation));
-		return std::move(resultBufferAllocation);
+	// Offset alignment that satisfies both uniform and storage buffer descriptors
+	[[nodiscard]] static vk::DeviceSize GetMinBufferOffsetAlignment()
+	{
+		return s_Allocator.m_MinBufferOffsetAlignment;
 	}
 
+	[[nodiscard]] static const char* GetCategoryName(MemoryCategory category);
+	// Cheap enough to be called every frame
+	[[nodiscard]] static MemoryStatistics GetMemoryStatistics();
+	// The statistics above followed by the detailed VMA map, where every allocation is named
+	// after its category
+	[[nodiscard]] static std::string BuildStatisticsJson();
+	static void DumpStatistics(const std::string& filename);
+
 	static void FreeMemory(VmaAllocation allocation);
 	static void DestroyImageAllocation(ImageAllocation& imageAllocation);
 	static void DestroyBufferAllocation(BufferAllocation& bufferAllocation);
@@ -124,12 +280,51 @@ public:
 
 private:
 	Allocator() noexcept;
+	// Releases the staging memory of completed uploads, blocking on the oldest one when wait is set
+	static void ReclaimStaging(bool wait);
+	// Copies staging memory into level 0 of a new sampled image, the other levels are generated
+	// when the format can be blitted with linear filtering
+	static std::unique_ptr<ImageAllocation> CreateSampledImage(UploadContext& upload,
+															   const StagingAllocation& staging,
+															   int width, int height,
+															   vk::Format format);
+	[[nodiscard]] static bool SupportsLinearBlit(vk::Format format);
+	[[nodiscard]] static vk::Format ChooseHdrTextureFormat();
+	// Fills levels 1 to mipLevels - 1 by blitting each level from the previous one. Level 0 has
+	// to be in eTransferDstOptimal, every level ends up in eShaderReadOnlyOptimal.
+	static void GenerateMipmaps(const vk::CommandBuffer& commandBuffer, vk::Image image,
+								int32_t width, int32_t height, uint32_t mipLevels);
+	// Names the allocation after its category and adds it to the category totals
+	static void TrackAllocation(VmaAllocation allocation, MemoryCategory category);
 
 private:
+	struct StagingSubmit
+	{
+		uint64_t m_Ticket;
+		// Ring bytes allocated for the submission, including alignment and wrap-around padding
+		vk::DeviceSize m_Size;
+		std::vector<std::unique_ptr<BufferAllocation>> m_Buffers;
+	};
+
+	static constexpr vk::DeviceSize s_StagingRingSize = 64 * 1024 * 1024;
+
 	static Allocator s_Allocator;
 	VmaAllocator m_Allocator{};
 	vk::PhysicalDevice m_PhysicalDevice;
 	vk::Device m_LogicalDevice;
+	vk::DeviceSize m_MinBufferOffsetAlignment = 1;
+	bool m_MemoryBudgetExtension = false;
+	vk::Format m_HdrTextureFormat = vk::Format::eR16G16B16A16Sfloat;
+	std::array<MemoryCategoryStatistics, static_cast<size_t>(MemoryCategory::Count)>
+		m_CategoryStatistics{};
+	// The live part of the ring is the m_StagingUsed bytes before m_StagingHead, wrapping around
+	std::unique_ptr<BufferAllocation> m_StagingRing;
+	uint8_t* m_StagingRingData = nullptr;
+	vk::DeviceSize m_StagingHead = 0;
+	vk::DeviceSize m_StagingUsed = 0;
+	vk::DeviceSize m_StagingOpen = 0;
+	// Dedicated buffers of requests that did not fit into the ring, not yet submitted
 	std::vector<std::unique_ptr<BufferAllocation>> m_StagingBuffers;
+	std::deque<StagingSubmit> m_StagingSubmits;
 };
 } // namespace Neon
@@ -0,0 +1,78 @@
+#include "OffsetAllocator.h"
+
+Neon::OffsetAllocator::OffsetAllocator(uint64_t size)
+	: m_Size(size)
+{
+	if (size) InsertFreeRange(0, size);
+}
+
+uint64_t Neon::OffsetAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(size > 0 && alignment > 0);
+	// Best fit first, larger ranges are only tried when alignment padding does not fit
+	auto it = m_FreeBySize.lower_bound(size);
+	uint64_t alignedOffset = 0;
+	for (; it != m_FreeBySize.end(); ++it)
+	{
+		alignedOffset = (it->second + alignment - 1) / alignment * alignment;
+		if (alignedOffset - it->second + size <= it->first) break;
+	}
+	if (it == m_FreeBySize.end()) return s_InvalidOffset;
+
+	uint64_t rangeOffset = it->second;
+	uint64_t rangeSize = it->first;
+	EraseFreeRange(rangeOffset, rangeSize);
+	if (alignedOffset > rangeOffset) InsertFreeRange(rangeOffset, alignedOffset - rangeOffset);
+	uint64_t end = alignedOffset + size;
+	if (end < rangeOffset + rangeSize) InsertFreeRange(end, rangeOffset + rangeSize - end);
+	return alignedOffset;
+}
+
+void Neon::OffsetAllocator::Free(uint64_t offset, uint64_t size)
+{
+	assert(offset + size <= m_Size);
+	auto next = m_FreeByOffset.find(offset + size);
+	if (next != m_FreeByOffset.end())
+	{
+		uint64_t nextSize = next->second;
+		EraseFreeRange(offset + size, nextSize);
+		size += nextSize;
+	}
+	auto previous = m_FreeByOffset.lower_bound(offset);
+	if (previous != m_FreeByOffset.begin())
+	{
+		--previous;
+		assert(previous->first + previous->second <= offset);
+		if (previous->first + previous->second == offset)
+		{
+			uint64_t previousOffset = previous->first;
+			uint64_t previousSize = previous->second;
+			EraseFreeRange(previousOffset, previousSize);
+			offset = previousOffset;
+			size += previousSize;
+		}
+	}
+	InsertFreeRange(offset, size);
+}
+
+void Neon::OffsetAllocator::InsertFreeRange(uint64_t offset, uint64_t size)
+{
+	m_FreeByOffset.emplace(offset, size);
+	m_FreeBySize.emplace(size, offset);
+	m_FreeSize += size;
+}
+
+void Neon::OffsetAllocator::EraseFreeRange(uint64_t offset, uint64_t size)
+{
+	m_FreeByOffset.erase(offset);
+	auto range = m_FreeBySize.equal_range(size);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == offset)
+		{
+			m_FreeBySize.erase(it);
+			break;
+		}
+	}
+	m_FreeSize -= size;
+}
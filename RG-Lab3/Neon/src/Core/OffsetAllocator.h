@@ -0,0 +1,47 @@
+#ifndef NEON_OFFSETALLOCATOR_H
+#define NEON_OFFSETALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+
+namespace Neon
+{
+// Hands out ranges of a fixed size address space, such as a buffer that is suballocated. Free
+// ranges are indexed by offset, to coalesce neighbours on free, and by size, to pick the best
+// fitting one on allocation. Only offsets are managed, the memory itself is never touched.
+class OffsetAllocator
+{
+public:
+	static constexpr uint64_t s_InvalidOffset = UINT64_MAX;
+
+	OffsetAllocator() = default;
+	explicit OffsetAllocator(uint64_t size);
+
+	// Returns s_InvalidOffset when no free range can hold size bytes at the given alignment,
+	// which does not have to be a power of two
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+	// Size has to be the one the range was allocated with
+	void Free(uint64_t offset, uint64_t size);
+
+	[[nodiscard]] uint64_t GetSize() const
+	{
+		return m_Size;
+	}
+	[[nodiscard]] uint64_t GetFreeSize() const
+	{
+		return m_FreeSize;
+	}
+
+private:
+	void InsertFreeRange(uint64_t offset, uint64_t size);
+	void EraseFreeRange(uint64_t offset, uint64_t size);
+
+private:
+	uint64_t m_Size = 0;
+	uint64_t m_FreeSize = 0;
+	std::map<uint64_t, uint64_t> m_FreeByOffset;
+	std::multimap<uint64_t, uint64_t> m_FreeBySize;
+};
+} // namespace Neon
+
+#endif //NEON_OFFSETALLOCATOR_H
@@ -96,5 +96,7 @@ bool Neon::Context::CheckValidationLayerSupport()
 
 void Neon::Context::InitAllocator()
 {
-	Neon::Allocator::Init(m_PhysicalDevice->GetHandle(), m_LogicalDevice->GetHandle());
+	Neon::Allocator::Init(m_VkInstance.get(), m_PhysicalDevice->GetHandle(),
+						  m_LogicalDevice->GetHandle(),
+						  m_PhysicalDevice->IsMemoryBudgetSupported());
 }
@@ -0,0 +1,121 @@
+#include "GeometryArena.h"
+
+#include "UploadContext.h"
+
+std::vector<Neon::GeometryArena::Block> Neon::GeometryArena::s_Blocks;
+
+Neon::GeometryAllocation::~GeometryAllocation()
+{
+	GeometryArena::Free(*this);
+}
+
+Neon::GeometryAllocation& Neon::GeometryAllocation::operator=(GeometryAllocation&& other) noexcept
+{
+	if (this == &other) return *this;
+	GeometryArena::Free(*this);
+	m_Block = other.m_Block;
+	m_VertexOffset = other.m_VertexOffset;
+	m_FirstIndex = other.m_FirstIndex;
+	m_VertexRangeOffset = other.m_VertexRangeOffset;
+	m_VertexRangeSize = other.m_VertexRangeSize;
+	m_IndexRangeOffset = other.m_IndexRangeOffset;
+	m_IndexRangeSize = other.m_IndexRangeSize;
+	other.m_Block = UINT32_MAX;
+	return *this;
+}
+
+void Neon::GeometryArena::Init()
+{
+	CreateBlock(s_VertexBlockSize, s_IndexBlockSize);
+}
+
+void Neon::GeometryArena::Shutdown()
+{
+	// Meshes destroyed later find no block and have nothing to free
+	s_Blocks.clear();
+}
+
+Neon::GeometryAllocation Neon::GeometryArena::Allocate(UploadContext& upload,
+													   const StagingAllocation& vertices,
+													   uint32_t vertexStride,
+													   const StagingAllocation& indices)
+{
+	assert(vertices.m_Size % vertexStride == 0 && indices.m_Size % sizeof(uint32_t) == 0);
+	GeometryAllocation allocation;
+	for (uint32_t i = 0; i <= s_Blocks.size() && allocation.m_Block == UINT32_MAX; i++)
+	{
+		if (i == s_Blocks.size())
+		{
+			CreateBlock(std::max(s_VertexBlockSize, vertices.m_Size + vertexStride),
+						std::max(s_IndexBlockSize, indices.m_Size));
+		}
+		Block& block = s_Blocks[i];
+		uint64_t vertexOffset = block.m_VertexRanges.Allocate(vertices.m_Size, vertexStride);
+		if (vertexOffset == OffsetAllocator::s_InvalidOffset) continue;
+		uint64_t indexOffset = block.m_IndexRanges.Allocate(indices.m_Size, sizeof(uint32_t));
+		if (indexOffset == OffsetAllocator::s_InvalidOffset)
+		{
+			block.m_VertexRanges.Free(vertexOffset, vertices.m_Size);
+			continue;
+		}
+		allocation.m_Block = i;
+		allocation.m_VertexOffset = static_cast<int32_t>(vertexOffset / vertexStride);
+		allocation.m_FirstIndex = static_cast<uint32_t>(indexOffset / sizeof(uint32_t));
+		allocation.m_VertexRangeOffset = vertexOffset;
+		allocation.m_VertexRangeSize = vertices.m_Size;
+		allocation.m_IndexRangeOffset = indexOffset;
+		allocation.m_IndexRangeSize = indices.m_Size;
+	}
+	assert(allocation.m_Block != UINT32_MAX);
+
+	const Block& block = s_Blocks[allocation.m_Block];
+	vk::CommandBuffer commandBuffer = upload.GetTransferCommandBuffer();
+	vk::BufferCopy vertexCopy{vertices.m_Offset, allocation.m_VertexRangeOffset, vertices.m_Size};
+	commandBuffer.copyBuffer(vertices.m_Buffer, block.m_VertexBuffer->m_Buffer, 1, &vertexCopy);
+	vk::BufferCopy indexCopy{indices.m_Offset, allocation.m_IndexRangeOffset, indices.m_Size};
+	commandBuffer.copyBuffer(indices.m_Buffer, block.m_IndexBuffer->m_Buffer, 1, &indexCopy);
+	// Only the written ranges change hands, other meshes of the block may be in use
+	upload.ReleaseBuffer(block.m_VertexBuffer->m_Buffer, allocation.m_VertexRangeOffset,
+						 allocation.m_VertexRangeSize);
+	upload.ReleaseBuffer(block.m_IndexBuffer->m_Buffer, allocation.m_IndexRangeOffset,
+						 allocation.m_IndexRangeSize);
+	return allocation;
+}
+
+void Neon::GeometryArena::Free(GeometryAllocation& allocation)
+{
+	if (allocation.m_Block < s_Blocks.size())
+	{
+		Block& block = s_Blocks[allocation.m_Block];
+		block.m_VertexRanges.Free(allocation.m_VertexRangeOffset, allocation.m_VertexRangeSize);
+		block.m_IndexRanges.Free(allocation.m_IndexRangeOffset, allocation.m_IndexRangeSize);
+	}
+	allocation.m_Block = UINT32_MAX;
+}
+
+void Neon::GeometryArena::Bind(const vk::CommandBuffer& commandBuffer, uint32_t block)
+{
+	assert(block < s_Blocks.size());
+	commandBuffer.bindVertexBuffers(0, {s_Blocks[block].m_VertexBuffer->m_Buffer}, {0});
+	commandBuffer.bindIndexBuffer(s_Blocks[block].m_IndexBuffer->m_Buffer, 0,
+								  vk::IndexType::eUint32);
+}
+
+uint32_t Neon::GeometryArena::CreateBlock(uint64_t vertexSize, uint64_t indexSize)
+{
+	Block block;
+	block.m_VertexBuffer = Allocator::CreateBuffer(
+		vertexSize,
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer |
+			vk::BufferUsageFlagBits::eStorageBuffer,
+		VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Mesh);
+	block.m_IndexBuffer = Allocator::CreateBuffer(
+		indexSize,
+		vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer |
+			vk::BufferUsageFlagBits::eStorageBuffer,
+		VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Mesh);
+	block.m_VertexRanges = OffsetAllocator(vertexSize);
+	block.m_IndexRanges = OffsetAllocator(indexSize);
+	s_Blocks.push_back(std::move(block));
+	return static_cast<uint32_t>(s_Blocks.size() - 1);
+}
@@ -0,0 +1,81 @@
+#ifndef NEON_GEOMETRYARENA_H
+#define NEON_GEOMETRYARENA_H
+
+#include "Allocator.h"
+#include "OffsetAllocator.h"
+
+namespace Neon
+{
+// Where a mesh lives inside the arena. Vertex offset and first index are ready to be passed to
+// drawIndexed, the byte ranges are what is handed back to the arena when the mesh is destroyed.
+struct GeometryAllocation
+{
+	GeometryAllocation() = default;
+	~GeometryAllocation();
+	GeometryAllocation(const GeometryAllocation&) = delete;
+	GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+	GeometryAllocation(GeometryAllocation&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+	GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+
+	uint32_t m_Block = UINT32_MAX;
+	int32_t m_VertexOffset = 0;
+	uint32_t m_FirstIndex = 0;
+	uint64_t m_VertexRangeOffset = 0;
+	uint64_t m_VertexRangeSize = 0;
+	uint64_t m_IndexRangeOffset = 0;
+	uint64_t m_IndexRangeSize = 0;
+};
+
+// Vertices and 32-bit indices of every mesh, suballocated from a few large device local buffers
+// instead of a pair of buffers per mesh. Meshes of one block are drawn after binding its buffers
+// once, with their offsets passed to the draw. Vertex ranges are aligned to the vertex stride, so
+// meshes with different vertex formats share a block. A new block is only added when no existing
+// one has room.
+class GeometryArena
+{
+public:
+	static void Init();
+	static void Shutdown();
+
+	// Records copies of vertices and indices already written to staging memory into the arena
+	static GeometryAllocation Allocate(UploadContext& upload, const StagingAllocation& vertices,
+									   uint32_t vertexStride, const StagingAllocation& indices);
+	template<typename V>
+	static GeometryAllocation Allocate(UploadContext& upload, const std::vector<V>& vertices,
+									   const std::vector<uint32_t>& indices)
+	{
+		StagingAllocation vertexStaging = Allocator::AllocateStaging(vertices.size() * sizeof(V));
+		memcpy(vertexStaging.m_Data, vertices.data(), vertexStaging.m_Size);
+		StagingAllocation indexStaging =
+			Allocator::AllocateStaging(indices.size() * sizeof(uint32_t));
+		memcpy(indexStaging.m_Data, indices.data(), indexStaging.m_Size);
+		return Allocate(upload, vertexStaging, sizeof(V), indexStaging);
+	}
+	// The ranges are reused right away, the GPU must no longer read them
+	static void Free(GeometryAllocation& allocation);
+
+	static void Bind(const vk::CommandBuffer& commandBuffer, uint32_t block);
+
+private:
+	struct Block
+	{
+		std::unique_ptr<BufferAllocation> m_VertexBuffer;
+		std::unique_ptr<BufferAllocation> m_IndexBuffer;
+		OffsetAllocator m_VertexRanges;
+		OffsetAllocator m_IndexRanges;
+	};
+
+	static uint32_t CreateBlock(uint64_t vertexSize, uint64_t indexSize);
+
+private:
+	static constexpr uint64_t s_VertexBlockSize = 64 * 1024 * 1024;
+	static constexpr uint64_t s_IndexBlockSize = 32 * 1024 * 1024;
+
+	static std::vector<Block> s_Blocks;
+};
+} // namespace Neon
+
+#endif //NEON_GEOMETRYARENA_H
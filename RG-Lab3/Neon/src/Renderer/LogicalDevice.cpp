@@ -15,7 +15,8 @@ Neon::LogicalDevice::Create(const PhysicalDevice& physicalDevice)
 Neon::LogicalDevice::LogicalDevice(const PhysicalDevice& physicalDevice)
 {
 	std::set<uint32_t> queueFamilyIndices = {physicalDevice.GetGraphicsQueueFamily().m_Index,
-											 physicalDevice.GetComputeQueueFamily().m_Index};
+											 physicalDevice.GetComputeQueueFamily().m_Index,
+											 physicalDevice.GetTransferQueueFamily().m_Index};
 	float queuePriority = 1.0f;
 	std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
 	queueCreateInfos.reserve(queueFamilyIndices.size());
@@ -61,4 +62,5 @@ Neon::LogicalDevice::LogicalDevice(const PhysicalDevice& physicalDevice)
 
 	m_GraphicsQueue = m_Handle.get().getQueue(physicalDevice.GetGraphicsQueueFamily().m_Index, 0);
 	m_PresentQueue = m_Handle.get().getQueue(physicalDevice.GetComputeQueueFamily().m_Index, 0);
+	m_TransferQueue = m_Handle.get().getQueue(physicalDevice.GetTransferQueueFamily().m_Index, 0);
 }
@@ -32,6 +32,15 @@ Neon::PhysicalDevice::PhysicalDevice(const vk::SurfaceKHR& surface,
 	m_MemoryProperties = m_Handle.getMemoryProperties();
 	m_SupportedExtensions = m_Handle.enumerateDeviceExtensionProperties();
 	m_RequiredExtensions = requiredExtensions;
+	// Optional, lets the allocator report the heap budgets of the driver
+	for (const auto& extension : m_SupportedExtensions)
+	{
+		if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+		{
+			m_MemoryBudgetSupported = true;
+			m_RequiredExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
+	}
 	FindQueueFamilies(surface);
 }
 
@@ -113,10 +122,16 @@ void Neon::PhysicalDevice::FindQueueFamilies(const vk::SurfaceKHR& surface)
 		{ m_PresentQueueFamily = queueFamily; }
 		if (queueFamilyProperty.queueFlags & vk::QueueFlagBits::eCompute)
 		{ m_ComputeQueueFamily = queueFamily; }
-		if (queueFamilyProperty.queueFlags & vk::QueueFlagBits::eTransfer)
+		// Prefer a family that only does transfers, which usually maps to a dedicated DMA engine
+		if ((queueFamilyProperty.queueFlags & vk::QueueFlagBits::eTransfer) &&
+			!(queueFamilyProperty.queueFlags &
+			  (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
 		{ m_TransferQueueFamily = queueFamily; }
 		if (queueFamilyProperty.queueFlags & vk::QueueFlagBits::eSparseBinding)
 		{ m_SparseBindingQueueFamily = queueFamily; }
 		index++;
 	}
+	// Graphics queues support transfers as well
+	if (m_TransferQueueFamily.m_Index == static_cast<uint32_t>(-1))
+	{ m_TransferQueueFamily = m_GraphicsQueueFamily; }
 }
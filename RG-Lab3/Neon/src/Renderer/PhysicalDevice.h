@@ -73,6 +73,10 @@ public:
 	{
 		return m_RequiredExtensions;
 	}
+	[[nodiscard]] bool IsMemoryBudgetSupported() const
+	{
+		return m_MemoryBudgetSupported;
+	}
 
 private:
 	PhysicalDevice(const vk::SurfaceKHR& surface,
@@ -100,6 +104,7 @@ private:
 	vk::PhysicalDeviceMemoryProperties m_MemoryProperties;
 	std::vector<vk::ExtensionProperties> m_SupportedExtensions;
 	std::vector<const char*> m_RequiredExtensions;
+	bool m_MemoryBudgetSupported = false;
 	QueueFamily m_GraphicsQueueFamily;
 	QueueFamily m_PresentQueueFamily;
 	QueueFamily m_ComputeQueueFamily;
@@ -9,13 +9,17 @@ vk::RenderPass Neon::CreateRenderPass(const vk::Device& device, vk::Format color
 									  vk::ImageLayout depthInitialLayout,
 									  vk::ImageLayout depthFinalLayout, bool resolve)
 {
+	// Multisampled attachments are only read by the resolve, so their contents never have to leave
+	// tile memory and lazily allocated memory backing them is never committed
+	const vk::AttachmentStoreOp storeOp =
+		resolve ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore;
 	std::vector<vk::AttachmentDescription2KHR> attachments;
 	vk::AttachmentDescription2KHR colorAttachment{{},
 												  colorAttachmentFormat,
 												  samples,
 												  clearColor ? vk::AttachmentLoadOp::eClear
 															 : vk::AttachmentLoadOp::eDontCare,
-												  vk::AttachmentStoreOp::eStore,
+												  storeOp,
 												  vk::AttachmentLoadOp::eDontCare,
 												  vk::AttachmentStoreOp::eDontCare,
 												  colorInitialLayout,
@@ -35,7 +39,7 @@ vk::RenderPass Neon::CreateRenderPass(const vk::Device& device, vk::Format color
 						   depthAttachmentFormat,
 						   samples,
 						   clearDepth ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad,
-						   vk::AttachmentStoreOp::eStore,
+						   storeOp,
 						   vk::AttachmentLoadOp::eDontCare,
 						   vk::AttachmentStoreOp::eDontCare,
 						   depthInitialLayout,
@@ -45,13 +49,24 @@ vk::RenderPass Neon::CreateRenderPass(const vk::Device& device, vk::Format color
 		subpassDescription.setPDepthStencilAttachment(&depthAttachmentRef);
 	}
 
-	vk::SubpassDependency2KHR subpassDependency{VK_SUBPASS_EXTERNAL,
-												0,
-												vk::PipelineStageFlagBits::eColorAttachmentOutput,
-												vk::PipelineStageFlagBits::eColorAttachmentOutput,
-												vk::AccessFlagBits{},
-												vk::AccessFlagBits::eColorAttachmentRead |
-													vk::AccessFlagBits::eColorAttachmentWrite};
+	// The targets of a render pass are shared by every frame in flight and sampled by later passes.
+	// The first dependency keeps a frame from writing them before the previous frame is done
+	// writing and sampling them, the second makes the written targets visible to the samplers.
+	const vk::PipelineStageFlags attachmentStages =
+		vk::PipelineStageFlagBits::eColorAttachmentOutput |
+		vk::PipelineStageFlagBits::eEarlyFragmentTests |
+		vk::PipelineStageFlagBits::eLateFragmentTests;
+	const vk::AccessFlags attachmentWrites = vk::AccessFlagBits::eColorAttachmentWrite |
+											 vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+	std::array<vk::SubpassDependency2KHR, 2> subpassDependencies = {
+		vk::SubpassDependency2KHR{VK_SUBPASS_EXTERNAL, 0,
+								  attachmentStages | vk::PipelineStageFlagBits::eFragmentShader,
+								  attachmentStages, attachmentWrites,
+								  attachmentWrites | vk::AccessFlagBits::eColorAttachmentRead |
+									  vk::AccessFlagBits::eDepthStencilAttachmentRead},
+		vk::SubpassDependency2KHR{0, VK_SUBPASS_EXTERNAL, attachmentStages,
+								  vk::PipelineStageFlagBits::eFragmentShader, attachmentWrites,
+								  vk::AccessFlagBits::eShaderRead}};
 
 	vk::AttachmentDescription2KHR colorAttachmentResolve;
 	vk::AttachmentReference2KHR colorAttachmentResolveReference;
@@ -88,13 +103,9 @@ vk::RenderPass Neon::CreateRenderPass(const vk::Device& device, vk::Format color
 		attachments.push_back(colorAttachmentResolve);
 		attachments.push_back(depthAttachmentResolve);
 	}
-	vk::RenderPassCreateInfo2KHR renderPassInfo = {{},
-												   static_cast<uint32_t>(attachments.size()),
-												   attachments.data(),
-												   1,
-												   &subpassDescription,
-												   1,
-												   &subpassDependency};
+	vk::RenderPassCreateInfo2KHR renderPassInfo = {
+		{}, static_cast<uint32_t>(attachments.size()), attachments.data(), 1, &subpassDescription,
+		static_cast<uint32_t>(subpassDependencies.size()), subpassDependencies.data()};
 	vk::DispatchLoaderDynamic dldi(Context::GetInstance().GetVkInstance(),
 								   Context::GetInstance().GetLogicalDevice().GetHandle());
 	dldi.vkCreateRenderPass2KHR = (PFN_vkCreateRenderPass2KHR)vkGetDeviceProcAddr(
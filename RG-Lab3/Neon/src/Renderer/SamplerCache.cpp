@@ -0,0 +1,54 @@
+#include "SamplerCache.h"
+
+#include "Context.h"
+
+std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, Neon::SamplerCache::CreateInfoHash>
+	Neon::SamplerCache::s_Samplers;
+
+void Neon::SamplerCache::Shutdown()
+{
+	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
+	for (auto& [createInfo, sampler] : s_Samplers)
+	{
+		device.destroySampler(sampler);
+	}
+	s_Samplers.clear();
+}
+
+vk::Sampler Neon::SamplerCache::Get(const vk::SamplerCreateInfo& createInfo)
+{
+	assert(!createInfo.pNext);
+	auto it = s_Samplers.find(createInfo);
+	if (it == s_Samplers.end())
+	{
+		const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
+		it = s_Samplers.emplace(createInfo, device.createSampler(createInfo)).first;
+	}
+	return it->second;
+}
+
+size_t
+Neon::SamplerCache::CreateInfoHash::operator()(const vk::SamplerCreateInfo& createInfo) const
+{
+	size_t hash = 0;
+	auto combine = [&hash](auto value) {
+		hash ^= std::hash<decltype(value)>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	};
+	combine(static_cast<VkSamplerCreateFlags>(createInfo.flags));
+	combine(createInfo.magFilter);
+	combine(createInfo.minFilter);
+	combine(createInfo.mipmapMode);
+	combine(createInfo.addressModeU);
+	combine(createInfo.addressModeV);
+	combine(createInfo.addressModeW);
+	combine(createInfo.mipLodBias);
+	combine(createInfo.anisotropyEnable);
+	combine(createInfo.maxAnisotropy);
+	combine(createInfo.compareEnable);
+	combine(createInfo.compareOp);
+	combine(createInfo.minLod);
+	combine(createInfo.maxLod);
+	combine(createInfo.borderColor);
+	combine(createInfo.unnormalizedCoordinates);
+	return hash;
+}
@@ -0,0 +1,35 @@
+#ifndef NEON_SAMPLERCACHE_H
+#define NEON_SAMPLERCACHE_H
+
+#include <unordered_map>
+#include <vulkan/vulkan.hpp>
+
+namespace Neon
+{
+// Samplers do not depend on the images they sample, so one is created per distinct create info
+// and shared by every descriptor using it. They are destroyed together on Shutdown.
+class SamplerCache
+{
+public:
+	static void Shutdown();
+
+	// The pNext chain is not part of the key and has to be empty
+	static vk::Sampler Get(const vk::SamplerCreateInfo& createInfo);
+
+	[[nodiscard]] static size_t GetSamplerCount()
+	{
+		return s_Samplers.size();
+	}
+
+private:
+	struct CreateInfoHash
+	{
+		size_t operator()(const vk::SamplerCreateInfo& createInfo) const;
+	};
+
+private:
+	static std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, CreateInfoHash> s_Samplers;
+};
+} // namespace Neon
+
+#endif //NEON_SAMPLERCACHE_H
@@ -4,8 +4,6 @@
 
 #include "SwapChain.h"
 
-#define MAX_FRAMES_IN_FLIGHT 2
-
 std::unique_ptr<Neon::SwapChain> Neon::SwapChain::Create(Window& window,
 														 const vk::Instance& instance,
 														 const vk::SurfaceKHR& surface,
@@ -26,7 +24,6 @@ Neon::SwapChain::SwapChain(Window& window, const vk::Instance& instance,
 	, m_PhysicalDevice(physicalDevice)
 {
 	CreateSwapChainHandle();
-	m_SwapChainFences.resize(m_SwapChainImageViews.size());
 
 	vk::SemaphoreCreateInfo semaphoreInfo{};
 	vk::FenceCreateInfo fenceInfo{vk::FenceCreateFlagBits::eSignaled};
@@ -57,13 +54,9 @@ vk::Result Neon::SwapChain::AcquireNextImage()
 		assert(result.result == vk::Result::eSuccess ||
 			   result.result == vk::Result::eSuboptimalKHR);
 	}
+	// Nothing recorded is tied to the image, so there is no need to wait for the frame that last
+	// rendered to it; the acquire semaphore orders the writes to the image itself
 	m_ImageIndex = result.value;
-	if (m_SwapChainFences[m_ImageIndex] != vk::Fence())
-	{
-		m_LogicalDevice.GetHandle().waitForFences(m_SwapChainFences[m_ImageIndex], VK_TRUE,
-												  UINT64_MAX);
-	}
-	m_SwapChainFences[m_ImageIndex] = m_FrameFences[m_FrameIndex].get();
 	return result.result;
 }
 
@@ -10,6 +10,10 @@
 #include "vulkan/vulkan.hpp"
 #include <Window/Window.h>
 
+// Frames the CPU may record ahead of the GPU, 2 or 3. More frames let the CPU run further ahead at
+// the cost of latency and of one more copy of every per frame resource.
+#define MAX_FRAMES_IN_FLIGHT 2
+
 namespace Neon
 {
 class SwapChain
@@ -50,6 +54,11 @@ public:
 	{
 		return m_ImageIndex;
 	}
+	// Frame being recorded, its previous submission has completed once AcquireNextImage returned
+	[[nodiscard]] uint32_t GetFrameIndex() const
+	{
+		return m_FrameIndex;
+	}
 
 private:
 	SwapChain(Window& window, const vk::Instance& instance, const vk::SurfaceKHR& surface,
@@ -70,7 +79,6 @@ private:
 	std::vector<vk::UniqueImageView> m_SwapChainImageViews;
 	std::vector<vk::UniqueSemaphore> m_ImageAcquiredSemaphores;
 	std::vector<vk::UniqueSemaphore> m_RenderFinishedSemaphores;
-	std::vector<vk::Fence> m_SwapChainFences;
 	std::vector<vk::UniqueFence> m_FrameFences;
 };
 } // namespace Neon
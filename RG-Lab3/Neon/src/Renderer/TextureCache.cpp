@@ -0,0 +1,71 @@
+#include "TextureCache.h"
+
+#include "Context.h"
+#include "SamplerCache.h"
+#include "VulkanRenderer.h"
+
+std::unordered_map<std::string, std::weak_ptr<Neon::Texture>> Neon::TextureCache::s_Textures;
+
+Neon::Texture::~Texture()
+{
+	Neon::Context::GetInstance().GetLogicalDevice().GetHandle().destroyImageView(
+		m_Descriptor.imageView);
+}
+
+std::shared_ptr<Neon::Texture> Neon::TextureCache::Get(UploadContext& upload,
+													   const std::string& filename, bool srgb)
+{
+	const vk::Format format = srgb ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+	const std::string key = (srgb ? "srgb:" : "linear:") + filename;
+	if (auto texture = Find(key)) return texture;
+	return Insert(key, Allocator::CreateTextureImage(upload, filename, format), format);
+}
+
+std::shared_ptr<Neon::Texture> Neon::TextureCache::GetSolidColor(UploadContext& upload,
+																 const glm::u8vec4& color)
+{
+	std::stringstream key;
+	key << "color:" << static_cast<int>(color.r) << ',' << static_cast<int>(color.g) << ','
+		<< static_cast<int>(color.b) << ',' << static_cast<int>(color.a);
+	if (auto texture = Find(key.str())) return texture;
+	// CreateTextureImage releases the pixels with stbi_image_free, which calls free
+	auto* pixels = static_cast<stbi_uc*>(malloc(sizeof(color)));
+	memcpy(pixels, &color, sizeof(color));
+	return Insert(key.str(), Allocator::CreateTextureImage(upload, pixels, 1, 1),
+				  vk::Format::eR8G8B8A8Srgb);
+}
+
+size_t Neon::TextureCache::GetTextureCount()
+{
+	return static_cast<size_t>(
+		std::count_if(s_Textures.begin(), s_Textures.end(),
+					  [](const auto& entry) { return !entry.second.expired(); }));
+}
+
+std::shared_ptr<Neon::Texture> Neon::TextureCache::Find(const std::string& key)
+{
+	auto it = s_Textures.find(key);
+	if (it == s_Textures.end()) return nullptr;
+	std::shared_ptr<Texture> texture = it->second.lock();
+	if (!texture) s_Textures.erase(it);
+	return texture;
+}
+
+std::shared_ptr<Neon::Texture> Neon::TextureCache::Insert(const std::string& key,
+														  std::unique_ptr<ImageAllocation> image,
+														  vk::Format format)
+{
+	assert(image);
+	auto texture = std::make_shared<Texture>();
+	texture->m_Image = std::move(image);
+	vk::SamplerCreateInfo samplerInfo = {
+		{}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear};
+	samplerInfo.setMaxLod(FLT_MAX);
+	texture->m_Descriptor = {
+		SamplerCache::Get(samplerInfo),
+		VulkanRenderer::CreateImageView(texture->m_Image->m_Image, format,
+										vk::ImageAspectFlagBits::eColor),
+		vk::ImageLayout::eShaderReadOnlyOptimal};
+	s_Textures[key] = texture;
+	return texture;
+}
@@ -0,0 +1,51 @@
+#ifndef NEON_TEXTURECACHE_H
+#define NEON_TEXTURECACHE_H
+
+#include "Allocator.h"
+
+#include <glm/glm.hpp>
+
+namespace Neon
+{
+// Sampled 8 bit RGBA texture shared through TextureCache. The view is destroyed with the texture,
+// the sampler belongs to SamplerCache.
+struct Texture
+{
+	Texture() = default;
+	~Texture();
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	std::unique_ptr<ImageAllocation> m_Image{};
+	vk::DescriptorImageInfo m_Descriptor{};
+};
+
+// Decodes and uploads every file once, however many meshes reference it. Textures are kept alive
+// by the components holding them and the cache only references them weakly, so a texture nothing
+// uses any more is freed and loaded again when it is requested next.
+class TextureCache
+{
+public:
+	// sRGB for colors, linear for data such as normal or distortion maps; the same file requested
+	// both ways is uploaded twice. A texture found in the cache may have been recorded on another
+	// upload context, which has to be submitted before the texture is drawn.
+	static std::shared_ptr<Texture> Get(UploadContext& upload, const std::string& filename,
+										bool srgb = true);
+	// Single texel texture, for materials without a texture of their own
+	static std::shared_ptr<Texture> GetSolidColor(UploadContext& upload, const glm::u8vec4& color);
+
+	// Textures still referenced by a component
+	[[nodiscard]] static size_t GetTextureCount();
+
+private:
+	static std::shared_ptr<Texture> Find(const std::string& key);
+	static std::shared_ptr<Texture> Insert(const std::string& key,
+										   std::unique_ptr<ImageAllocation> image,
+										   vk::Format format);
+
+private:
+	static std::unordered_map<std::string, std::weak_ptr<Texture>> s_Textures;
+};
+} // namespace Neon
+
+#endif //NEON_TEXTURECACHE_H
@@ -0,0 +1,231 @@
+#include "UploadContext.h"
+
+#include "Allocator.h"
+#include "Context.h"
+
+vk::CommandPool Neon::UploadContext::s_TransferCommandPool;
+vk::CommandPool Neon::UploadContext::s_GraphicsCommandPool;
+std::deque<Neon::UploadContext::Submission> Neon::UploadContext::s_Submissions;
+std::vector<vk::Fence> Neon::UploadContext::s_FreeFences;
+std::vector<vk::Semaphore> Neon::UploadContext::s_FreeSemaphores;
+uint64_t Neon::UploadContext::s_LastTicket = 0;
+uint64_t Neon::UploadContext::s_CompletedTicket = 0;
+
+Neon::UploadContext::~UploadContext()
+{
+	Submit();
+}
+
+void Neon::UploadContext::Init()
+{
+	const auto& device = Context::GetInstance().GetLogicalDevice().GetHandle();
+	const auto& physicalDevice = Context::GetInstance().GetPhysicalDevice();
+	s_GraphicsCommandPool =
+		device.createCommandPool({vk::CommandPoolCreateFlagBits::eTransient,
+								  physicalDevice.GetGraphicsQueueFamily().m_Index});
+	if (HasTransferQueue())
+	{
+		s_TransferCommandPool = device.createCommandPool(
+			{vk::CommandPoolCreateFlagBits::eTransient,
+			 physicalDevice.GetTransferQueueFamily().m_Index});
+	}
+}
+
+void Neon::UploadContext::Shutdown()
+{
+	const auto& device = Context::GetInstance().GetLogicalDevice().GetHandle();
+	Wait(s_LastTicket);
+	for (auto& fence : s_FreeFences)
+		device.destroyFence(fence);
+	for (auto& semaphore : s_FreeSemaphores)
+		device.destroySemaphore(semaphore);
+	s_FreeFences.clear();
+	s_FreeSemaphores.clear();
+	device.destroyCommandPool(s_TransferCommandPool);
+	device.destroyCommandPool(s_GraphicsCommandPool);
+	s_TransferCommandPool = nullptr;
+	s_GraphicsCommandPool = nullptr;
+}
+
+vk::CommandBuffer Neon::UploadContext::GetTransferCommandBuffer()
+{
+	if (!HasTransferQueue()) return GetGraphicsCommandBuffer();
+	if (!m_TransferCommandBuffer)
+		m_TransferCommandBuffer = BeginCommandBuffer(s_TransferCommandPool);
+	return m_TransferCommandBuffer;
+}
+
+vk::CommandBuffer Neon::UploadContext::GetGraphicsCommandBuffer()
+{
+	if (!m_GraphicsCommandBuffer)
+		m_GraphicsCommandBuffer = BeginCommandBuffer(s_GraphicsCommandPool);
+	return m_GraphicsCommandBuffer;
+}
+
+void Neon::UploadContext::ReleaseBuffer(vk::Buffer buffer, vk::DeviceSize offset,
+										vk::DeviceSize size)
+{
+	const auto& physicalDevice = Context::GetInstance().GetPhysicalDevice();
+	vk::AccessFlags readAccess = vk::AccessFlagBits::eVertexAttributeRead |
+								 vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eUniformRead |
+								 vk::AccessFlagBits::eShaderRead;
+	vk::PipelineStageFlags readStages = vk::PipelineStageFlagBits::eVertexInput |
+										vk::PipelineStageFlagBits::eVertexShader |
+										vk::PipelineStageFlagBits::eFragmentShader;
+	vk::BufferMemoryBarrier barrier{vk::AccessFlagBits::eTransferWrite,
+									readAccess,
+									VK_QUEUE_FAMILY_IGNORED,
+									VK_QUEUE_FAMILY_IGNORED,
+									buffer,
+									offset,
+									size};
+	if (HasTransferQueue())
+	{
+		barrier.srcQueueFamilyIndex = physicalDevice.GetTransferQueueFamily().m_Index;
+		barrier.dstQueueFamilyIndex = physicalDevice.GetGraphicsQueueFamily().m_Index;
+		vk::BufferMemoryBarrier release = barrier;
+		release.dstAccessMask = {};
+		GetTransferCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+												   vk::PipelineStageFlagBits::eBottomOfPipe, {},
+												   {}, {release}, {});
+		barrier.srcAccessMask = {};
+	}
+	GetGraphicsCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, readStages, {},
+											   {}, {barrier}, {});
+}
+
+void Neon::UploadContext::ReleaseImage(vk::Image image, vk::ImageAspectFlagBits aspect,
+									   vk::ImageLayout newLayout, vk::PipelineStageFlags dstStages,
+									   vk::AccessFlags dstAccess)
+{
+	const auto& physicalDevice = Context::GetInstance().GetPhysicalDevice();
+	vk::ImageSubresourceRange imgSubresourceRange{aspect, 0, VK_REMAINING_MIP_LEVELS, 0,
+												  VK_REMAINING_ARRAY_LAYERS};
+	vk::ImageMemoryBarrier barrier{vk::AccessFlagBits::eTransferWrite,
+								   dstAccess,
+								   vk::ImageLayout::eTransferDstOptimal,
+								   newLayout,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   VK_QUEUE_FAMILY_IGNORED,
+								   image,
+								   imgSubresourceRange};
+	if (HasTransferQueue())
+	{
+		// The layout transition is part of the ownership transfer, both barriers must describe it
+		barrier.srcQueueFamilyIndex = physicalDevice.GetTransferQueueFamily().m_Index;
+		barrier.dstQueueFamilyIndex = physicalDevice.GetGraphicsQueueFamily().m_Index;
+		vk::ImageMemoryBarrier release = barrier;
+		release.dstAccessMask = {};
+		GetTransferCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+												   vk::PipelineStageFlagBits::eBottomOfPipe, {},
+												   {}, {}, {release});
+		barrier.srcAccessMask = {};
+	}
+	GetGraphicsCommandBuffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStages, {},
+											   {}, {}, {barrier});
+}
+
+uint64_t Neon::UploadContext::Submit()
+{
+	if (!m_TransferCommandBuffer && !m_GraphicsCommandBuffer) return s_LastTicket;
+
+	const auto& logicalDevice = Context::GetInstance().GetLogicalDevice();
+	const auto& device = logicalDevice.GetHandle();
+	Poll();
+
+	Submission submission{++s_LastTicket};
+	if (s_FreeFences.empty()) { submission.m_Fence = device.createFence({}); }
+	else
+	{
+		submission.m_Fence = s_FreeFences.back();
+		s_FreeFences.pop_back();
+	}
+
+	if (m_TransferCommandBuffer)
+	{
+		if (s_FreeSemaphores.empty()) { submission.m_Semaphore = device.createSemaphore({}); }
+		else
+		{
+			submission.m_Semaphore = s_FreeSemaphores.back();
+			s_FreeSemaphores.pop_back();
+		}
+		m_TransferCommandBuffer.end();
+		vk::SubmitInfo submitInfo{
+			0, nullptr, nullptr, 1, &m_TransferCommandBuffer, 1, &submission.m_Semaphore};
+		logicalDevice.GetTransferQueue().submit(submitInfo, nullptr);
+		submission.m_TransferCommandBuffer = m_TransferCommandBuffer;
+	}
+
+	// The graphics submission always exists, it carries the fence even when it only waits
+	GetGraphicsCommandBuffer().end();
+	vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eTransfer;
+	vk::SubmitInfo submitInfo{submission.m_Semaphore ? 1u : 0u, &submission.m_Semaphore,
+							  &waitStage, 1, &m_GraphicsCommandBuffer};
+	logicalDevice.GetGraphicsQueue().submit(submitInfo, submission.m_Fence);
+	submission.m_GraphicsCommandBuffer = m_GraphicsCommandBuffer;
+
+	// Staging memory written since the previous submission is recycled with this ticket
+	Allocator::SubmitStaging(submission.m_Ticket);
+	s_Submissions.push_back(submission);
+	m_TransferCommandBuffer = nullptr;
+	m_GraphicsCommandBuffer = nullptr;
+	return submission.m_Ticket;
+}
+
+void Neon::UploadContext::Flush()
+{
+	Wait(Submit());
+}
+
+bool Neon::UploadContext::IsComplete(uint64_t ticket)
+{
+	Poll();
+	return ticket <= s_CompletedTicket;
+}
+
+void Neon::UploadContext::Wait(uint64_t ticket)
+{
+	assert(ticket <= s_LastTicket);
+	const auto& device = Context::GetInstance().GetLogicalDevice().GetHandle();
+	Poll();
+	while (s_CompletedTicket < ticket)
+	{
+		device.waitForFences(s_Submissions.front().m_Fence, VK_TRUE, UINT64_MAX);
+		Poll();
+	}
+}
+
+bool Neon::UploadContext::HasTransferQueue()
+{
+	const auto& physicalDevice = Context::GetInstance().GetPhysicalDevice();
+	return physicalDevice.GetTransferQueueFamily().m_Index !=
+		   physicalDevice.GetGraphicsQueueFamily().m_Index;
+}
+
+vk::CommandBuffer Neon::UploadContext::BeginCommandBuffer(vk::CommandPool commandPool)
+{
+	const auto& device = Context::GetInstance().GetLogicalDevice().GetHandle();
+	vk::CommandBufferAllocateInfo allocInfo{commandPool, vk::CommandBufferLevel::ePrimary, 1};
+	vk::CommandBuffer commandBuffer = device.allocateCommandBuffers(allocInfo)[0];
+	commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+	return commandBuffer;
+}
+
+void Neon::UploadContext::Poll()
+{
+	const auto& device = Context::GetInstance().GetLogicalDevice().GetHandle();
+	// Submissions end on the graphics queue, so their fences signal in order
+	while (!s_Submissions.empty())
+	{
+		Submission& submission = s_Submissions.front();
+		if (device.getFenceStatus(submission.m_Fence) != vk::Result::eSuccess) break;
+		device.resetFences(submission.m_Fence);
+		s_FreeFences.push_back(submission.m_Fence);
+		if (submission.m_Semaphore) s_FreeSemaphores.push_back(submission.m_Semaphore);
+		if (submission.m_TransferCommandBuffer)
+			device.freeCommandBuffers(s_TransferCommandPool, submission.m_TransferCommandBuffer);
+		device.freeCommandBuffers(s_GraphicsCommandPool, submission.m_GraphicsCommandBuffer);
+		s_CompletedTicket = submission.m_Ticket;
+		s_Submissions.pop_front();
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef NEON_UPLOADCONTEXT_H
+#define NEON_UPLOADCONTEXT_H
+
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace Neon
+{
+// Records any number of copies and barriers and submits them together, instead of a submit and a
+// queue drain per operation. Copies go to the dedicated transfer queue when the device has one:
+// resources written there are released to the graphics queue and acquired by a second command
+// buffer that waits on the transfer with a semaphore. Each submission gets an increasing ticket
+// whose completion is tracked with a fence, so the CPU only blocks when it calls Wait.
+class UploadContext
+{
+public:
+	UploadContext() = default;
+	// Submits what was recorded and not submitted yet, without waiting for it
+	~UploadContext();
+
+	UploadContext(const UploadContext&) = delete;
+	UploadContext(UploadContext&&) = delete;
+	UploadContext& operator=(const UploadContext&) = delete;
+	UploadContext& operator=(UploadContext&&) = delete;
+
+	static void Init();
+	static void Shutdown();
+
+	// Copies out of staging memory
+	vk::CommandBuffer GetTransferCommandBuffer();
+	// Work that needs the graphics queue, it executes after the copies of the same submission
+	vk::CommandBuffer GetGraphicsCommandBuffer();
+
+	// Makes a buffer or image written on the transfer command buffer available to the graphics
+	// queue. Images have to be in eTransferDstOptimal and end up in newLayout, ready for shader
+	// reads unless other graphics stages and accesses are given.
+	void ReleaseBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0,
+					   vk::DeviceSize size = VK_WHOLE_SIZE);
+	void ReleaseImage(vk::Image image, vk::ImageAspectFlagBits aspect, vk::ImageLayout newLayout,
+					  vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eFragmentShader,
+					  vk::AccessFlags dstAccess = vk::AccessFlagBits::eShaderRead);
+
+	// Returns the ticket of the submission, or of the last one when nothing was recorded
+	uint64_t Submit();
+	// Submits and waits for everything up to this submission to complete
+	void Flush();
+
+	[[nodiscard]] static bool IsComplete(uint64_t ticket);
+	static void Wait(uint64_t ticket);
+
+private:
+	struct Submission
+	{
+		uint64_t m_Ticket;
+		vk::Fence m_Fence;
+		vk::Semaphore m_Semaphore;
+		vk::CommandBuffer m_TransferCommandBuffer;
+		vk::CommandBuffer m_GraphicsCommandBuffer;
+	};
+
+	[[nodiscard]] static bool HasTransferQueue();
+	static vk::CommandBuffer BeginCommandBuffer(vk::CommandPool commandPool);
+	// Recycles the objects of completed submissions, oldest first
+	static void Poll();
+
+private:
+	vk::CommandBuffer m_TransferCommandBuffer;
+	vk::CommandBuffer m_GraphicsCommandBuffer;
+
+	static vk::CommandPool s_TransferCommandPool;
+	static vk::CommandPool s_GraphicsCommandPool;
+	static std::deque<Submission> s_Submissions;
+	static std::vector<vk::Fence> s_FreeFences;
+	static std::vector<vk::Semaphore> s_FreeSemaphores;
+	static uint64_t s_LastTicket;
+	static uint64_t s_CompletedTicket;
+};
+} // namespace Neon
+
+#endif //NEON_UPLOADCONTEXT_H
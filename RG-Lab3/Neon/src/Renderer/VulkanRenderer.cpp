@@ -2,7 +2,10 @@
 
 #include "Allocator.h"
 #include "Context.h"
+#include "GeometryArena.h"
 #include "RenderPass.h"
+#include "SamplerCache.h"
+#include "UploadContext.h"
 #include "Window.h"
 
 #include <examples/imgui_impl_glfw.h>
@@ -16,14 +19,18 @@ Neon::VulkanRenderer Neon::VulkanRenderer::s_Instance;
 
 Neon::VulkanRenderer::VulkanRenderer() noexcept { }
 
-void Neon::VulkanRenderer::Init(Window* window)
+void Neon::VulkanRenderer::Init(Window* window, const RenderTargetSettings& settings)
 {
-	s_Instance.InitRenderer(window);
+	s_Instance.InitRenderer(window, settings);
 }
 
 void Neon::VulkanRenderer::Shutdown()
 {
 	Neon::Context::GetInstance().GetLogicalDevice().GetHandle().waitIdle();
+	GeometryArena::Shutdown();
+	SamplerCache::Shutdown();
+	UploadContext::Shutdown();
+	Allocator::Shutdown();
 }
 
 void Neon::VulkanRenderer::Begin()
@@ -33,15 +40,18 @@ void Neon::VulkanRenderer::Begin()
 	else
 	{
 		assert(result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR);
+		// The fence of the frame was waited on by the acquire, nothing recorded into it is pending
+		const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
+		device.resetCommandPool(
+			s_Instance.m_Frames[s_Instance.m_SwapChain->GetFrameIndex()].m_CommandPool.get(), {});
 		vk::CommandBufferBeginInfo beginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
-		s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get().begin(beginInfo);
+		s_Instance.GetCommandBuffer().begin(beginInfo);
 	}
 }
 
 void Neon::VulkanRenderer::End()
 {
-	auto& commandBuffer =
-		s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get();
+	auto& commandBuffer = s_Instance.GetCommandBuffer();
 	commandBuffer.end();
 	auto result = s_Instance.m_SwapChain->Present(commandBuffer);
 
@@ -53,7 +63,7 @@ void Neon::VulkanRenderer::End()
 	}
 }
 
-void Neon::VulkanRenderer::BeginScene(const std::vector<vk::UniqueFramebuffer>& frameBuffers,
+void Neon::VulkanRenderer::BeginScene(const vk::UniqueFramebuffer& frameBuffer,
 									  const vk::Extent2D& extent, const glm::vec4& clearColor,
 									  const Neon::PerspectiveCamera& camera,
 									  const glm::vec4& clippingPlane, bool pointLight,
@@ -69,67 +79,43 @@ void Neon::VulkanRenderer::BeginScene(const std::vector<vk::UniqueFramebuffer>&
 	s_Instance.m_PushConstant.lightDirection = lightDirection;
 	s_Instance.m_PushConstant.lightPosition = lightPosition;
 
-	auto& commandBuffer =
-		s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get();
+	auto& commandBuffer = s_Instance.GetCommandBuffer();
 	std::array<vk::ClearValue, 2> clearValues = {};
 	memcpy(&clearValues[0].color.float32, &clearColor, sizeof(clearValues[0].color.float32));
 	clearValues[1].depthStencil = vk::ClearDepthStencilValue{1.0f, 0};
 	vk::RenderPassBeginInfo renderPassInfo{
 		s_Instance.m_OffscreenRenderPass.get(),
-		frameBuffers[s_Instance.m_SwapChain->GetImageIndex()].get(),
+		frameBuffer.get(),
 		{{0, 0}, extent},
 		static_cast<uint32_t>(clearValues.size()),
 		clearValues.data()};
 	commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+	s_Instance.m_BoundGeometryBlock = UINT32_MAX;
 }
 
 void Neon::VulkanRenderer::EndScene()
 {
-	s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get().endRenderPass();
+	s_Instance.GetCommandBuffer().endRenderPass();
 }
 
 void Neon::VulkanRenderer::DrawImGui()
 {
-	auto& commandBuffer =
-		s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get();
+	auto& commandBuffer = s_Instance.GetCommandBuffer();
 
 	vk::RenderPassBeginInfo renderPassInfo{
 		s_Instance.m_ImGuiRenderPass.get(),
 		s_Instance.m_ImGuiFrameBuffers[s_Instance.m_SwapChain->GetImageIndex()].get(),
 		{{0, 0}, s_Instance.m_SwapChain->GetExtent()}};
 	commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-	ImGui_ImplVulkan_RenderDrawData(
-		ImGui::GetDrawData(),
-		s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get());
+	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 	commandBuffer.endRenderPass();
 }
 
-vk::CommandBuffer Neon::VulkanRenderer::BeginSingleTimeCommands()
-{
-	auto& logicalDevice = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
-	vk::CommandBufferAllocateInfo allocInfo{s_Instance.m_CommandPool.get(),
-											vk::CommandBufferLevel::ePrimary, 1};
-	vk::CommandBuffer commandBuffer = logicalDevice.allocateCommandBuffers(allocInfo)[0];
-	vk::CommandBufferBeginInfo beginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit};
-	commandBuffer.begin(beginInfo);
-	return commandBuffer;
-}
-
-void Neon::VulkanRenderer::EndSingleTimeCommands(vk::CommandBuffer commandBuffer)
-{
-	const auto& logicalDevice = Neon::Context::GetInstance().GetLogicalDevice();
-	commandBuffer.end();
-	vk::SubmitInfo submitInfo{0, nullptr, nullptr, 1, &commandBuffer};
-	logicalDevice.GetGraphicsQueue().submit(submitInfo, nullptr);
-	logicalDevice.GetGraphicsQueue().waitIdle();
-	logicalDevice.GetHandle().freeCommandBuffers(s_Instance.m_CommandPool.get(), commandBuffer);
-}
-
 vk::ImageView Neon::VulkanRenderer::CreateImageView(vk::Image image, vk::Format format,
 													const vk::ImageAspectFlags& aspectFlags)
 {
 	auto& logicalDevice = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
-	vk::ImageSubresourceRange subResourceRange(aspectFlags, 0, 1, 0, 1);
+	vk::ImageSubresourceRange subResourceRange(aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, 1);
 	vk::ImageViewCreateInfo imageViewCreateInfo{{},		image, vk::ImageViewType::e2D,
 												format, {},	   subResourceRange};
 	return logicalDevice.createImageView(imageViewCreateInfo);
@@ -140,24 +126,20 @@ Neon::VulkanRenderer::CreateImageViewUnique(vk::Image image, vk::Format format,
 											const vk::ImageAspectFlags& aspectFlags)
 {
 	auto& logicalDevice = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
-	vk::ImageSubresourceRange subResourceRange(aspectFlags, 0, 1, 0, 1);
+	vk::ImageSubresourceRange subResourceRange(aspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, 1);
 	vk::ImageViewCreateInfo imageViewCreateInfo{{},		image, vk::ImageViewType::e2D,
 												format, {},	   subResourceRange};
 	return logicalDevice.createImageViewUnique(imageViewCreateInfo);
 }
 
-vk::Sampler Neon::VulkanRenderer::CreateSampler(const vk::SamplerCreateInfo& createInfo)
+void Neon::VulkanRenderer::InitRenderer(Window* window, const RenderTargetSettings& settings)
 {
-	return Neon::Context::GetInstance().GetLogicalDevice().GetHandle().createSampler(createInfo);
-}
-
-void Neon::VulkanRenderer::InitRenderer(Window* window)
-{
-	//TODO: swap chain image size should not effect number of descriptor sets and uniform buffers
 	Neon::Context::GetInstance().Init();
 	Neon::Context::GetInstance().CreateSurface(window);
 	Neon::Context::GetInstance().CreateDevice({vk::QueueFlagBits::eGraphics});
 	Neon::Context::GetInstance().InitAllocator();
+	UploadContext::Init();
+	GeometryArena::Init();
 
 	const auto& physicalDevice = Neon::Context::GetInstance().GetPhysicalDevice();
 	const auto& logicalDevice = Neon::Context::GetInstance().GetLogicalDevice();
@@ -165,33 +147,84 @@ void Neon::VulkanRenderer::InitRenderer(Window* window)
 		SwapChain::Create(*window, Context::GetInstance().GetVkInstance(),
 						  Context::GetInstance().GetSurface(), physicalDevice, logicalDevice);
 
+	m_RenderTargetSettings = ChooseRenderTargetSettings(settings);
+	m_LazyMsaaTargets = Allocator::IsLazilyAllocatedMemorySupported();
 	m_OffscreenRenderPass = vk::UniqueRenderPass(
-		Neon::CreateRenderPass(logicalDevice.GetHandle(), vk::Format::eR32G32B32A32Sfloat,
-							   s_MsaaSamples, true, vk::ImageLayout::eGeneral,
-							   vk::ImageLayout::eGeneral, vk::Format::eD32Sfloat, true,
+		Neon::CreateRenderPass(logicalDevice.GetHandle(), m_RenderTargetSettings.m_ColorFormat,
+							   m_RenderTargetSettings.m_Samples, true, vk::ImageLayout::eGeneral,
+							   vk::ImageLayout::eGeneral, m_RenderTargetSettings.m_DepthFormat,
+							   true, vk::ImageLayout::eDepthStencilReadOnlyOptimal,
 							   vk::ImageLayout::eDepthStencilReadOnlyOptimal,
-							   vk::ImageLayout::eDepthStencilReadOnlyOptimal, true),
+							   m_RenderTargetSettings.m_Samples != vk::SampleCountFlagBits::e1),
 		logicalDevice.GetHandle());
 
-	CreateCommandPool();
+	CreateFrames();
 	IntegrateImGui();
 	CreateOffscreenRenderer();
 	CreateImGuiRenderer();
-	CreateCommandBuffers();
 
 	///////////////////////////
 	std::vector<vk::DescriptorPoolSize> sizes;
 	sizes.emplace_back(vk::DescriptorType::eStorageBuffer,
-					   1 * MAX_SWAP_CHAIN_IMAGES * MAX_DESCRIPTOR_SETS_PER_POOL);
+					   1 * MAX_FRAMES_IN_FLIGHT * MAX_DESCRIPTOR_SETS_PER_POOL);
 	sizes.emplace_back(vk::DescriptorType::eCombinedImageSampler,
-					   10 * MAX_SWAP_CHAIN_IMAGES * MAX_DESCRIPTOR_SETS_PER_POOL);
+					   10 * MAX_FRAMES_IN_FLIGHT * MAX_DESCRIPTOR_SETS_PER_POOL);
 	m_DescriptorPools.push_back(DescriptorPool::Create(
-		logicalDevice.GetHandle(), sizes, MAX_SWAP_CHAIN_IMAGES * MAX_DESCRIPTOR_SETS_PER_POOL));
+		logicalDevice.GetHandle(), sizes, MAX_FRAMES_IN_FLIGHT * MAX_DESCRIPTOR_SETS_PER_POOL));
 	////////////////////////
 
 	Neon::Context::GetInstance().GetLogicalDevice().GetHandle().waitIdle();
 }
 
+Neon::RenderTargetSettings
+Neon::VulkanRenderer::ChooseRenderTargetSettings(const RenderTargetSettings& requested)
+{
+	const auto& physicalDevice = Neon::Context::GetInstance().GetPhysicalDevice();
+	auto supports = [&physicalDevice](vk::Format format, const vk::FormatFeatureFlags& features) {
+		auto properties = physicalDevice.GetHandle().getFormatProperties(format);
+		return (properties.optimalTilingFeatures & features) == features;
+	};
+
+	RenderTargetSettings settings;
+	// Every pipeline blends, so the color target has to support it besides being sampled
+	const vk::FormatFeatureFlags colorFeatures = vk::FormatFeatureFlagBits::eColorAttachment |
+												 vk::FormatFeatureFlagBits::eColorAttachmentBlend |
+												 vk::FormatFeatureFlagBits::eSampledImage;
+	for (vk::Format format : {requested.m_ColorFormat, vk::Format::eR16G16B16A16Sfloat,
+							  vk::Format::eR32G32B32A32Sfloat})
+	{
+		if (supports(format, colorFeatures))
+		{
+			settings.m_ColorFormat = format;
+			break;
+		}
+	}
+
+	// Views of formats with a stencil aspect could not be both attached and sampled
+	const bool depthOnly = requested.m_DepthFormat == vk::Format::eD16Unorm ||
+						   requested.m_DepthFormat == vk::Format::eX8D24UnormPack32 ||
+						   requested.m_DepthFormat == vk::Format::eD32Sfloat;
+	if (depthOnly && supports(requested.m_DepthFormat,
+							  vk::FormatFeatureFlagBits::eDepthStencilAttachment |
+								  vk::FormatFeatureFlagBits::eSampledImage))
+		settings.m_DepthFormat = requested.m_DepthFormat;
+
+	const auto& limits = physicalDevice.GetProperties().limits;
+	const vk::SampleCountFlags sampleCounts =
+		limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+	settings.m_Samples = vk::SampleCountFlagBits::e1;
+	for (vk::SampleCountFlagBits samples :
+		 {vk::SampleCountFlagBits::e8, vk::SampleCountFlagBits::e4, vk::SampleCountFlagBits::e2})
+	{
+		if (samples <= requested.m_Samples && (sampleCounts & samples))
+		{
+			settings.m_Samples = samples;
+			break;
+		}
+	}
+	return settings;
+}
+
 void Neon::VulkanRenderer::WindowResized()
 {
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
@@ -237,13 +270,16 @@ void Neon::VulkanRenderer::IntegrateImGui()
 	imguiInfo.DescriptorPool = m_ImGuiDescriptorPool->GetHandle();
 	imguiInfo.Allocator = nullptr;
 	imguiInfo.MinImageCount = (uint32_t)m_SwapChain->GetImageViewSize();
-	imguiInfo.ImageCount = (uint32_t)m_SwapChain->GetImageViewSize();
+	// ImGui cycles through ImageCount sets of vertex buffers, each frame in flight needs its own
+	imguiInfo.ImageCount =
+		std::max((uint32_t)m_SwapChain->GetImageViewSize(), (uint32_t)MAX_FRAMES_IN_FLIGHT);
 	imguiInfo.CheckVkResultFn = nullptr;
 	ImGui_ImplVulkan_Init(&imguiInfo, m_ImGuiRenderPass.get());
 
-	vk::CommandBuffer commandBuffer = BeginSingleTimeCommands();
-	ImGui_ImplVulkan_CreateFontsTexture(commandBuffer);
-	EndSingleTimeCommands(commandBuffer);
+	UploadContext upload;
+	ImGui_ImplVulkan_CreateFontsTexture(upload.GetGraphicsCommandBuffer());
+	// ImGui's own staging buffer has to outlive the copy
+	upload.Flush();
 
 	m_ImGuiOffscreenTextureDescSet = ImGui_ImplVulkan_CreateTexture();
 }
@@ -253,7 +289,7 @@ void Neon::VulkanRenderer::CreateOffscreenRenderer()
 	const auto& extent = s_Instance.m_SwapChain->GetExtent();
 	CreateFrameBuffers(extent, m_SampledOffscreenColorTextureImage,
 					   m_SampledOffscreenDepthTextureImage, m_OffscreenColorTextureImage,
-					   m_OffscreenDepthTextureImage, m_OffscreenFrameBuffers);
+					   m_OffscreenDepthTextureImage, m_OffscreenFrameBuffer);
 	ImGui_ImplVulkan_UpdateTexture(
 		m_ImGuiOffscreenTextureDescSet, m_OffscreenColorTextureImage.m_Descriptor.sampler,
 		m_OffscreenColorTextureImage.m_Descriptor.imageView,
@@ -280,22 +316,19 @@ void Neon::VulkanRenderer::CreateImGuiRenderer()
 	}
 }
 
-void Neon::VulkanRenderer::CreateCommandPool()
+void Neon::VulkanRenderer::CreateFrames()
 {
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 	const auto& physicalDevice = Neon::Context::GetInstance().GetPhysicalDevice();
-	vk::CommandPoolCreateInfo poolInfo{vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-									   physicalDevice.GetGraphicsQueueFamily().m_Index};
-	m_CommandPool = device.createCommandPoolUnique(poolInfo);
-}
-
-void Neon::VulkanRenderer::CreateCommandBuffers()
-{
-	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
-	m_CommandBuffers.resize(m_SwapChain->GetImageViewSize());
-	vk::CommandBufferAllocateInfo allocInfo{m_CommandPool.get(), vk::CommandBufferLevel::ePrimary,
-											static_cast<uint32_t>(m_CommandBuffers.size())};
-	m_CommandBuffers = device.allocateCommandBuffersUnique(allocInfo);
+	for (Frame& frame : m_Frames)
+	{
+		vk::CommandPoolCreateInfo poolInfo{vk::CommandPoolCreateFlagBits::eTransient,
+										   physicalDevice.GetGraphicsQueueFamily().m_Index};
+		frame.m_CommandPool = device.createCommandPoolUnique(poolInfo);
+		vk::CommandBufferAllocateInfo allocInfo{frame.m_CommandPool.get(),
+												vk::CommandBufferLevel::ePrimary, 1};
+		frame.m_CommandBuffer = std::move(device.allocateCommandBuffersUnique(allocInfo)[0]);
+	}
 }
 
 void Neon::VulkanRenderer::CreateFrameBuffers(vk::Extent2D extent,
@@ -303,80 +336,103 @@ void Neon::VulkanRenderer::CreateFrameBuffers(vk::Extent2D extent,
 											  Neon::TextureImage& sampledDepthTextureImage,
 											  Neon::TextureImage& colorTextureImage,
 											  Neon::TextureImage& depthTextureImage,
-											  std::vector<vk::UniqueFramebuffer>& frameBuffers)
+											  vk::UniqueFramebuffer& frameBuffer)
 {
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
+	const RenderTargetSettings& settings = s_Instance.m_RenderTargetSettings;
+	const bool multisampled = settings.m_Samples != vk::SampleCountFlagBits::e1;
+	UploadContext upload;
+	auto commandBuffer = upload.GetGraphicsCommandBuffer();
+
+	// Reassigning the images would leak the views and samplers created for the previous extent
+	for (TextureImage* image : {&sampledColorTextureImage, &sampledDepthTextureImage,
+								&colorTextureImage, &depthTextureImage})
+	{
+		Allocator::DestroyTextureImage(*image);
+		*image = TextureImage();
+	}
 
-	sampledColorTextureImage.m_TextureAllocation = Allocator::CreateImage(
-		extent.width, extent.height, VulkanRenderer::GetMsaaSamples(),
-		vk::Format::eR32G32B32A32Sfloat, vk::ImageTiling::eOptimal,
-		vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransientAttachment,
-		VMA_MEMORY_USAGE_GPU_ONLY);
-	Neon::Allocator::TransitionImageLayout(sampledColorTextureImage.m_TextureAllocation->m_Image,
-										   vk::ImageAspectFlagBits::eColor,
-										   vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
-	sampledColorTextureImage.m_Descriptor.imageView = VulkanRenderer::CreateImageView(
-		sampledColorTextureImage.m_TextureAllocation->m_Image, vk::Format::eR32G32B32A32Sfloat,
-		vk::ImageAspectFlagBits::eColor);
-
-	sampledDepthTextureImage.m_TextureAllocation =
-		Neon::Allocator::CreateImage(extent.width, extent.height, VulkanRenderer::GetMsaaSamples(),
-									 vk::Format::eD32Sfloat, vk::ImageTiling::eOptimal,
-									 vk::ImageUsageFlagBits::eDepthStencilAttachment |
-										 vk::ImageUsageFlagBits::eTransientAttachment,
-									 VMA_MEMORY_USAGE_GPU_ONLY);
-	Neon::Allocator::TransitionImageLayout(
-		sampledDepthTextureImage.m_TextureAllocation->m_Image, vk::ImageAspectFlagBits::eDepth,
-		vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
-	sampledDepthTextureImage.m_Descriptor.imageView =
-		VulkanRenderer::CreateImageView(sampledDepthTextureImage.m_TextureAllocation->m_Image,
-										vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth);
+	// Without multisampling the scene is rendered straight into the sampled targets
+	if (multisampled)
+	{
+		const VmaMemoryUsage memoryUsage = s_Instance.m_LazyMsaaTargets
+											   ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED
+											   : VMA_MEMORY_USAGE_GPU_ONLY;
+		sampledColorTextureImage.m_TextureAllocation = Allocator::CreateImage(
+			extent.width, extent.height, 1, settings.m_Samples, settings.m_ColorFormat,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransientAttachment,
+			memoryUsage, MemoryCategory::MsaaTarget);
+		Neon::Allocator::TransitionImageLayout(
+			commandBuffer, sampledColorTextureImage.m_TextureAllocation->m_Image,
+			vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eUndefined,
+			vk::ImageLayout::eGeneral);
+		sampledColorTextureImage.m_Descriptor.imageView = VulkanRenderer::CreateImageView(
+			sampledColorTextureImage.m_TextureAllocation->m_Image, settings.m_ColorFormat,
+			vk::ImageAspectFlagBits::eColor);
+
+		sampledDepthTextureImage.m_TextureAllocation = Neon::Allocator::CreateImage(
+			extent.width, extent.height, 1, settings.m_Samples, settings.m_DepthFormat,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eDepthStencilAttachment |
+				vk::ImageUsageFlagBits::eTransientAttachment,
+			memoryUsage, MemoryCategory::MsaaTarget);
+		Neon::Allocator::TransitionImageLayout(
+			commandBuffer, sampledDepthTextureImage.m_TextureAllocation->m_Image,
+			vk::ImageAspectFlagBits::eDepth, vk::ImageLayout::eUndefined,
+			vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+		sampledDepthTextureImage.m_Descriptor.imageView = VulkanRenderer::CreateImageView(
+			sampledDepthTextureImage.m_TextureAllocation->m_Image, settings.m_DepthFormat,
+			vk::ImageAspectFlagBits::eDepth);
+	}
 
 	colorTextureImage.m_TextureAllocation = Neon::Allocator::CreateImage(
-		extent.width, extent.height, vk::SampleCountFlagBits::e1, vk::Format::eR32G32B32A32Sfloat,
+		extent.width, extent.height, 1, vk::SampleCountFlagBits::e1, settings.m_ColorFormat,
 		vk::ImageTiling::eOptimal,
 		vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
-		VMA_MEMORY_USAGE_GPU_ONLY);
-	Neon::Allocator::TransitionImageLayout(colorTextureImage.m_TextureAllocation->m_Image,
-										   vk::ImageAspectFlagBits::eColor,
-										   vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
-	colorTextureImage.m_Descriptor.imageView = VulkanRenderer::CreateImageView(
-		colorTextureImage.m_TextureAllocation->m_Image, vk::Format::eR32G32B32A32Sfloat,
-		vk::ImageAspectFlagBits::eColor);
-	colorTextureImage.m_Descriptor.sampler = VulkanRenderer::CreateSampler(vk::SamplerCreateInfo());
+		VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::RenderTarget);
+	Neon::Allocator::TransitionImageLayout(
+		commandBuffer, colorTextureImage.m_TextureAllocation->m_Image,
+		vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+	colorTextureImage.m_Descriptor.imageView =
+		VulkanRenderer::CreateImageView(colorTextureImage.m_TextureAllocation->m_Image,
+										settings.m_ColorFormat, vk::ImageAspectFlagBits::eColor);
+	colorTextureImage.m_Descriptor.sampler = SamplerCache::Get(vk::SamplerCreateInfo());
 	colorTextureImage.m_Descriptor.imageLayout = vk::ImageLayout::eGeneral;
 
 	depthTextureImage.m_TextureAllocation = Neon::Allocator::CreateImage(
-		extent.width, extent.height, vk::SampleCountFlagBits::e1, vk::Format::eD32Sfloat,
+		extent.width, extent.height, 1, vk::SampleCountFlagBits::e1, settings.m_DepthFormat,
 		vk::ImageTiling::eOptimal,
 		vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
-		VMA_MEMORY_USAGE_GPU_ONLY);
+		VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::RenderTarget);
 	Neon::Allocator::TransitionImageLayout(
-		depthTextureImage.m_TextureAllocation->m_Image, vk::ImageAspectFlagBits::eDepth,
-		vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+		commandBuffer, depthTextureImage.m_TextureAllocation->m_Image,
+		vk::ImageAspectFlagBits::eDepth, vk::ImageLayout::eUndefined,
+		vk::ImageLayout::eDepthStencilReadOnlyOptimal);
 	depthTextureImage.m_Descriptor.imageView =
 		VulkanRenderer::CreateImageView(depthTextureImage.m_TextureAllocation->m_Image,
-										vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth);
-	depthTextureImage.m_Descriptor.sampler = VulkanRenderer::CreateSampler(vk::SamplerCreateInfo());
+										settings.m_DepthFormat, vk::ImageAspectFlagBits::eDepth);
+	depthTextureImage.m_Descriptor.sampler = SamplerCache::Get(vk::SamplerCreateInfo());
 	depthTextureImage.m_Descriptor.imageLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
 
-	frameBuffers.clear();
-	frameBuffers.reserve(MAX_SWAP_CHAIN_IMAGES);
-	for (size_t i = 0; i < MAX_SWAP_CHAIN_IMAGES; i++)
+	// One framebuffer serves every frame in flight, the dependencies of the offscreen render pass
+	// order the frames' accesses to the shared targets
+	std::vector<vk::ImageView> attachments = {colorTextureImage.m_Descriptor.imageView,
+											  depthTextureImage.m_Descriptor.imageView};
+	if (multisampled)
 	{
-		std::vector<vk::ImageView> attachments = {sampledColorTextureImage.m_Descriptor.imageView,
-												  sampledDepthTextureImage.m_Descriptor.imageView,
-												  colorTextureImage.m_Descriptor.imageView,
-												  depthTextureImage.m_Descriptor.imageView};
-
-		vk::FramebufferCreateInfo framebufferInfo;
-		framebufferInfo.setRenderPass(VulkanRenderer::GetOffscreenRenderPass());
-		framebufferInfo.setAttachmentCount(static_cast<uint32_t>(attachments.size()));
-		framebufferInfo.setPAttachments(attachments.data());
-		framebufferInfo.setWidth(extent.width);
-		framebufferInfo.setHeight(extent.height);
-		framebufferInfo.setLayers(1);
-
-		frameBuffers.push_back(device.createFramebufferUnique(framebufferInfo));
+		attachments.insert(attachments.begin(), {sampledColorTextureImage.m_Descriptor.imageView,
+												 sampledDepthTextureImage.m_Descriptor.imageView});
 	}
+
+	vk::FramebufferCreateInfo framebufferInfo;
+	framebufferInfo.setRenderPass(VulkanRenderer::GetOffscreenRenderPass());
+	framebufferInfo.setAttachmentCount(static_cast<uint32_t>(attachments.size()));
+	framebufferInfo.setPAttachments(attachments.data());
+	framebufferInfo.setWidth(extent.width);
+	framebufferInfo.setHeight(extent.height);
+	framebufferInfo.setLayers(1);
+	frameBuffer = device.createFramebufferUnique(framebufferInfo);
+	// Rendering is submitted to the same queue later, nothing has to wait for the transitions
+	upload.Submit();
 }
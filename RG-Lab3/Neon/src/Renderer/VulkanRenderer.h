@@ -18,8 +18,6 @@
 #include "SwapChain.h"
 #include "Window.h"
 
-#define MAX_SWAP_CHAIN_IMAGES 8
-
 namespace Neon
 {
 struct PushConstant
@@ -40,6 +38,17 @@ struct PushConstant
 	float moveFactor;
 };
 
+// Formats and sample count of the offscreen targets scenes are rendered to. With more than one
+// sample the color and depth targets are multisampled and resolved into the sampled images.
+struct RenderTargetSettings
+{
+	vk::Format m_ColorFormat = vk::Format::eR16G16B16A16Sfloat;
+	// Has to be a depth only format, the depth target is sampled by the water shader
+	vk::Format m_DepthFormat = vk::Format::eD32Sfloat;
+	// Four samples are supported for color and depth attachments by every device
+	vk::SampleCountFlagBits m_Samples = vk::SampleCountFlagBits::e4;
+};
+
 class VulkanRenderer
 {
 public:
@@ -47,29 +56,35 @@ public:
 	VulkanRenderer(const VulkanRenderer&& other) = delete;
 	VulkanRenderer& operator=(const VulkanRenderer&) = delete;
 	VulkanRenderer& operator=(const VulkanRenderer&&) = delete;
-	static void Init(Window* window);
+	// Settings the device does not support fall back to the closest supported ones
+	static void Init(Window* window, const RenderTargetSettings& settings = {});
 	static void Shutdown();
 	static void Begin();
 	static void End();
-	static void BeginScene(const std::vector<vk::UniqueFramebuffer>& frameBuffers,
+	static void BeginScene(const vk::UniqueFramebuffer& frameBuffer,
 						   const vk::Extent2D& extent, const glm::vec4& clearColor,
 						   const Neon::PerspectiveCamera& camera, const glm::vec4& clippingPlane,
 						   bool pointLight, float lightIntensity, glm::vec3 lightDirection,
 						   const glm::vec3& lightPosition);
 	static void EndScene();
 	static void DrawImGui();
-	static vk::CommandBuffer BeginSingleTimeCommands();
-	static void EndSingleTimeCommands(vk::CommandBuffer commandBuffer);
 	static vk::ImageView CreateImageView(vk::Image image, vk::Format format,
 										 const vk::ImageAspectFlags& aspectFlags);
 	static vk::UniqueImageView CreateImageViewUnique(vk::Image image, vk::Format format,
 													 const vk::ImageAspectFlags& aspectFlags);
-	static vk::Sampler CreateSampler(const vk::SamplerCreateInfo& createInfo);
 	static void* GetOffscreenImageID()
 	{
 		assert(s_Instance.m_ImGuiOffscreenTextureDescSet);
 		return s_Instance.m_ImGuiOffscreenTextureDescSet;
 	}
+	// Frame in flight being recorded between Begin and End, per frame resources such as
+	// descriptor sets and dynamic buffer slices are selected with it. Begin waits until the GPU is
+	// done with the previous use of the frame, so they can be rewritten right away.
+	static uint32_t GetFrameIndex()
+	{
+		assert(s_Instance.m_SwapChain);
+		return s_Instance.m_SwapChain->GetFrameIndex();
+	}
 	static vk::Extent2D GetExtent2D()
 	{
 		assert(s_Instance.m_SwapChain);
@@ -87,19 +102,27 @@ public:
 	}
 	static vk::SampleCountFlagBits GetMsaaSamples()
 	{
-		return s_MsaaSamples;
+		return s_Instance.m_RenderTargetSettings.m_Samples;
+	}
+	// Pipelines are created for the offscreen render pass, so the settings stay fixed after Init
+	static const RenderTargetSettings& GetRenderTargetSettings()
+	{
+		return s_Instance.m_RenderTargetSettings;
+	}
+	static bool AreMsaaTargetsLazilyAllocated()
+	{
+		return s_Instance.m_LazyMsaaTargets;
 	}
-	static const std::vector<vk::UniqueFramebuffer>& GetOffscreenFramebuffers()
+	static const vk::UniqueFramebuffer& GetOffscreenFramebuffer()
 	{
-		return s_Instance.m_OffscreenFrameBuffers;
+		return s_Instance.m_OffscreenFrameBuffer;
 	}
 
 	template<typename T>
 	static void Render(const Transform& transformComponent, const T& renderer, vk::Extent2D extent,
 					   float moveFactor)
 	{
-		auto& commandBuffer =
-			s_Instance.m_CommandBuffers[s_Instance.m_SwapChain->GetImageIndex()].get();
+		auto& commandBuffer = s_Instance.GetCommandBuffer();
 		vk::Viewport viewport{
 			0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height),
 			0.0f, 1.0f};
@@ -112,11 +135,10 @@ public:
 
 		if (renderer.m_DescriptorSets.size() > 0)
 		{
-			assert(s_Instance.m_SwapChain->GetImageIndex() < renderer.m_DescriptorSets.size());
+			assert(GetFrameIndex() < renderer.m_DescriptorSets.size());
 			commandBuffer.bindDescriptorSets(
 				vk::PipelineBindPoint::eGraphics, renderer.m_GraphicsPipeline.GetLayout(), 0, 1,
-				&renderer.m_DescriptorSets[s_Instance.m_SwapChain->GetImageIndex()].Get(), 0,
-				nullptr);
+				&renderer.m_DescriptorSets[GetFrameIndex()].Get(), 0, nullptr);
 		}
 
 		s_Instance.m_PushConstant.model = transformComponent.m_Global;
@@ -126,23 +148,30 @@ public:
 										vk::ShaderStageFlagBits::eFragment,
 									0, sizeof(PushConstant), &s_Instance.m_PushConstant);
 
-		commandBuffer.bindVertexBuffers(0, {renderer.m_Mesh.m_VertexBuffer->m_Buffer}, {0});
-		commandBuffer.bindIndexBuffer(renderer.m_Mesh.m_IndexBuffer->m_Buffer, 0,
-									  vk::IndexType::eUint32);
+		const auto& geometry = renderer.m_Mesh.m_Geometry;
+		if (s_Instance.m_BoundGeometryBlock != geometry.m_Block)
+		{
+			GeometryArena::Bind(commandBuffer, geometry.m_Block);
+			s_Instance.m_BoundGeometryBlock = geometry.m_Block;
+		}
 
-		commandBuffer.drawIndexed(static_cast<uint32_t>(renderer.m_Mesh.m_IndicesCount), 1, 0, 0,
-								  0);
+		commandBuffer.drawIndexed(static_cast<uint32_t>(renderer.m_Mesh.m_IndicesCount), 1,
+								  geometry.m_FirstIndex, geometry.m_VertexOffset, 0);
 	}
 
 private:
 	VulkanRenderer() noexcept;
-	void InitRenderer(Window* window);
+	void InitRenderer(Window* window, const RenderTargetSettings& settings);
+	static RenderTargetSettings ChooseRenderTargetSettings(const RenderTargetSettings& requested);
 	void WindowResized();
 	void IntegrateImGui();
 	void CreateOffscreenRenderer();
 	void CreateImGuiRenderer();
-	void CreateCommandPool();
-	void CreateCommandBuffers();
+	void CreateFrames();
+	vk::CommandBuffer& GetCommandBuffer()
+	{
+		return m_Frames[m_SwapChain->GetFrameIndex()].m_CommandBuffer.get();
+	}
 
 public:
 	static void CreateFrameBuffers(vk::Extent2D extent,
@@ -150,35 +179,45 @@ public:
 								   Neon::TextureImage& sampledDepthTextureImage,
 								   Neon::TextureImage& colorTextureImage,
 								   Neon::TextureImage& depthTextureImage,
-								   std::vector<vk::UniqueFramebuffer>& frameBuffers);
+								   vk::UniqueFramebuffer& frameBuffer);
 
 private:
-	static VulkanRenderer s_Instance;
+	// What one frame in flight records into. The pool is reset as a whole when the frame begins,
+	// after the fence of its previous submission has been waited on.
+	struct Frame
+	{
+		vk::UniqueCommandPool m_CommandPool;
+		vk::UniqueCommandBuffer m_CommandBuffer;
+	};
 
-	static const auto s_MsaaSamples = vk::SampleCountFlagBits::e8;
+private:
+	static VulkanRenderer s_Instance;
 
 	std::unique_ptr<SwapChain> m_SwapChain;
 
+	RenderTargetSettings m_RenderTargetSettings;
+	bool m_LazyMsaaTargets = false;
 	vk::UniqueRenderPass m_OffscreenRenderPass;
 	TextureImage m_SampledOffscreenColorTextureImage;
 	TextureImage m_SampledOffscreenDepthTextureImage;
 	TextureImage m_OffscreenColorTextureImage;
 	TextureImage m_OffscreenDepthTextureImage;
-	std::vector<vk::UniqueFramebuffer> m_OffscreenFrameBuffers;
+	vk::UniqueFramebuffer m_OffscreenFrameBuffer;
 
 	vk::UniqueRenderPass m_ImGuiRenderPass;
 	std::vector<vk::UniqueFramebuffer> m_ImGuiFrameBuffers;
 	VkDescriptorSet m_ImGuiOffscreenTextureDescSet = nullptr;
 
-	vk::UniqueCommandPool m_CommandPool;
-
 	std::vector<std::unique_ptr<DescriptorPool>> m_DescriptorPools;
 
 	std::shared_ptr<DescriptorPool> m_ImGuiDescriptorPool;
 
-	std::vector<vk::UniqueCommandBuffer> m_CommandBuffers;
+	std::array<Frame, MAX_FRAMES_IN_FLIGHT> m_Frames;
 
+	// Copied into the command buffer when pushed, so one instance serves every frame in flight
 	PushConstant m_PushConstant{};
+	// Arena block whose buffers are bound in the current render pass
+	uint32_t m_BoundGeometryBlock = UINT32_MAX;
 };
 } // namespace Neon
 
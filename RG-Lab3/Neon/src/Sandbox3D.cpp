@@ -2,6 +2,8 @@
 
 #include "Event.h"
 #include "Layer.h"
+#include "Renderer/SamplerCache.h"
+#include "Renderer/TextureCache.h"
 #include "Renderer/VulkanRenderer.h"
 
 #include <examples/imgui_impl_glfw.h>
@@ -107,6 +109,46 @@ void Sandbox3D::OnImGuiRender()
 	ImGui::SliderFloat3("Light Position", &lightPosition.x, -20.f, 20.f);
 	ImGui::End();
 
+	ImGui::Begin("Memory");
+	Neon::MemoryStatistics memory = Neon::Allocator::GetMemoryStatistics();
+	const float mebibyte = 1024.0f * 1024.0f;
+	ImGui::Text("Heap budgets %s", memory.m_MemoryBudgetExtension ? "(VK_EXT_memory_budget)"
+																  : "(estimated)");
+	for (size_t i = 0; i < memory.m_Heaps.size(); i++)
+	{
+		const auto& heap = memory.m_Heaps[i];
+		ImGui::Text("Heap %zu%s: %.1f MiB allocated, %.1f / %.1f MiB used", i,
+					heap.m_DeviceLocal ? " (device local)" : "",
+					static_cast<float>(heap.m_AllocationBytes) / mebibyte,
+					static_cast<float>(heap.m_Usage) / mebibyte,
+					static_cast<float>(heap.m_Budget) / mebibyte);
+		ImGui::ProgressBar(heap.m_Budget ? static_cast<float>(heap.m_Usage) /
+											   static_cast<float>(heap.m_Budget)
+										 : 0.0f);
+	}
+	ImGui::Separator();
+	for (size_t i = 0; i < memory.m_Categories.size(); i++)
+	{
+		ImGui::Text("%-14s %8.1f MiB in %u allocations",
+					Neon::Allocator::GetCategoryName(static_cast<Neon::MemoryCategory>(i)),
+					static_cast<float>(memory.m_Categories[i].m_Bytes) / mebibyte,
+					memory.m_Categories[i].m_AllocationCount);
+	}
+	const Neon::RenderTargetSettings& targets = Neon::VulkanRenderer::GetRenderTargetSettings();
+	ImGui::Text("Render targets %s / %s, %ux MSAA%s", vk::to_string(targets.m_ColorFormat).c_str(),
+				vk::to_string(targets.m_DepthFormat).c_str(),
+				static_cast<uint32_t>(targets.m_Samples),
+				Neon::VulkanRenderer::AreMsaaTargetsLazilyAllocated() ? " (lazily allocated)" : "");
+	ImGui::Text("%zu textures, %zu samplers", Neon::TextureCache::GetTextureCount(),
+				Neon::SamplerCache::GetSamplerCount());
+	ImGui::Separator();
+	ImGui::Text("Staging ring %.1f / %.1f MiB, %u uploads pending, %u unsubmitted buffers",
+				static_cast<float>(memory.m_StagingRingUsed) / mebibyte,
+				static_cast<float>(memory.m_StagingRingSize) / mebibyte,
+				memory.m_PendingStagingSubmits, memory.m_OpenStagingBuffers);
+	if (ImGui::Button("Dump to JSON")) Neon::Allocator::DumpStatistics("memory_statistics.json");
+	ImGui::End();
+
 	ImGui::Begin("Viewport");
 	vk::Extent2D extent = Neon::VulkanRenderer::GetExtent2D();
 	ImGui::Image(Neon::VulkanRenderer::GetOffscreenImageID(),
@@ -68,7 +68,7 @@ void Neon::Animation::LoadAnimation(const aiScene* scene, const aiNode* node, in
 	}
 }
 
-void Neon::Animation::Update(float seconds, std::vector<glm::mat4>& transforms, Bone& rootBone)
+void Neon::Animation::Update(float seconds, const Span<glm::mat4>& transforms, Bone& rootBone)
 {
 	CalculateBoneTransforms(rootBone, glm::mat4(1.0f), transforms);
 	m_CurrentAnimationTime += seconds * m_TicksPerSecond;
@@ -81,7 +81,7 @@ void Neon::Animation::Reset()
 }
 
 void Neon::Animation::CalculateBoneTransforms(Bone& bone, glm::mat4 parentTransform,
-											  std::vector<glm::mat4>& transforms)
+											  const Span<glm::mat4>& transforms)
 {
 	glm::mat4 nodeTransform = bone.GetLocalTransform();
 	if (bone.m_Animated)
@@ -101,8 +101,10 @@ void Neon::Animation::CalculateBoneTransforms(Bone& bone, glm::mat4 parentTransf
 	}
 
 	auto newParentTransform = parentTransform * bone.GetParentTransform() * nodeTransform;
-	transforms[bone.GetID()] = newParentTransform * bone.GetOffsetMatrix();
-	bone.SetAnimatedTransform(transforms[bone.GetID()]);
+	// Transforms may point to write combined memory, it is only stored to and never read back
+	glm::mat4 boneTransform = newParentTransform * bone.GetOffsetMatrix();
+	transforms[bone.GetID()] = boneTransform;
+	bone.SetAnimatedTransform(boneTransform);
 
 	for (auto& child : bone.GetChildren())
 	{
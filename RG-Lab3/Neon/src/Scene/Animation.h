@@ -6,6 +6,7 @@
 #define NEON_ANIMATION_H
 
 #include "Bone.h"
+#include <Core/Allocator.h>
 #include <assimp/scene.h>
 
 namespace Neon
@@ -40,14 +41,14 @@ class Animation
 public:
 	Animation(const aiScene* scene, int index, std::unordered_map<std::string, uint32_t>& boneMap,
 			  uint32_t bonesCount);
-	void Update(float seconds, std::vector<glm::mat4>& transforms, Bone& rootBone);
+	void Update(float seconds, const Span<glm::mat4>& transforms, Bone& rootBone);
 	void Reset();
 
 private:
 	void LoadAnimation(const aiScene* scene, const aiNode* node, int animationIndex,
 					   std::unordered_map<std::string, uint32_t>& boneMap);
 	void CalculateBoneTransforms(Bone& bone, glm::mat4 parentTransform,
-								 std::vector<glm::mat4>& transforms);
+								 const Span<glm::mat4>& transforms);
 
 private:
 	std::vector<std::vector<KeyFrameVector>> m_ScalingKeyFrames;
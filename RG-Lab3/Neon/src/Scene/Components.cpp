@@ -10,9 +10,16 @@ Neon::WaterRenderer::WaterRenderer()
 	VulkanRenderer::CreateFrameBuffers(
 		refractionReflectionResolution, m_RefractionSampledColorTextureImage,
 		m_RefractionSampledDepthTextureImage, m_RefractionColorTextureImage,
-		m_RefractionDepthTextureImage, m_RefractionFrameBuffers);
+		m_RefractionDepthTextureImage, m_RefractionFrameBuffer);
 	VulkanRenderer::CreateFrameBuffers(
 		refractionReflectionResolution, m_ReflectionSampledColorTextureImage,
 		m_ReflectionSampledDepthTextureImage, m_ReflectionColorTextureImage,
-		m_ReflectionDepthTextureImage, m_ReflectionFrameBuffers);
+		m_ReflectionDepthTextureImage, m_ReflectionFrameBuffer);
+}
+
+void Neon::SkinnedMeshRenderer::Update(float seconds)
+{
+	// The slice of the frame being recorded is no longer read by the GPU once Begin returned
+	m_Animation->Update(seconds, m_BoneBuffer.GetSlice<glm::mat4>(VulkanRenderer::GetFrameIndex()),
+						m_RootBone);
 }
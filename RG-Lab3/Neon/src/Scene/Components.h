@@ -12,7 +12,9 @@
 #include "GraphicsPipeline.h"
 #include <Core/Allocator.h>
 #include <Renderer/DescriptorSet.h>
+#include <Renderer/GeometryArena.h>
 #include <Renderer/GraphicsPipeline.h>
+#include <Renderer/TextureCache.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
@@ -52,8 +54,7 @@ struct Mesh
 {
 	uint32_t m_VerticesCount{0};
 	uint32_t m_IndicesCount{0};
-	std::unique_ptr<BufferAllocation> m_VertexBuffer{};
-	std::unique_ptr<BufferAllocation> m_IndexBuffer{};
+	GeometryAllocation m_Geometry{};
 };
 
 struct SkyDomeRenderer
@@ -83,7 +84,8 @@ struct SkinnedMeshRenderer
 
 	Bone m_RootBone;
 	uint32_t m_BoneSize;
-	std::unique_ptr<BufferAllocation> m_BoneBuffer{};
+	// One slice of m_BoneSize matrices per frame in flight
+	DynamicBuffer m_BoneBuffer{};
 
 	std::unique_ptr<Animation> m_Animation = nullptr;
 
@@ -91,7 +93,7 @@ struct SkinnedMeshRenderer
 	std::vector<DescriptorSet> m_DescriptorSets;
 
 	std::shared_ptr<BufferAllocation> m_MaterialBuffer{};
-	std::vector<TextureImage> m_TextureImages;
+	std::vector<std::shared_ptr<Texture>> m_Textures;
 
 	SkinnedMeshRenderer(const aiScene* scene, int index,
 						std::unordered_map<std::string, uint32_t>& boneMap,
@@ -104,12 +106,7 @@ struct SkinnedMeshRenderer
 		m_Animation = std::make_unique<Animation>(scene, index, boneMap, m_BoneSize);
 	}
 
-	void Update(float seconds)
-	{
-		std::vector<glm::mat4> transforms(m_BoneSize);
-		m_Animation->Update(seconds, transforms, m_RootBone);
-		Allocator::UpdateAllocation(m_BoneBuffer->m_Allocation, transforms);
-	}
+	void Update(float seconds);
 
 	void CreateBoneTree(const aiScene* scene, const aiNode* node, Bone& parentBone,
 						glm::mat4 parentTransform, int animationIndex,
@@ -178,7 +175,7 @@ struct MeshRenderer
 	std::vector<DescriptorSet> m_DescriptorSets;
 
 	std::shared_ptr<BufferAllocation> m_MaterialBuffer{};
-	std::vector<TextureImage> m_TextureImages;
+	std::vector<std::shared_ptr<Texture>> m_Textures;
 
 	MeshRenderer() = default;
 };
@@ -191,11 +188,11 @@ struct TerrainRenderer
 	std::vector<DescriptorSet> m_DescriptorSets;
 
 	std::unique_ptr<BufferAllocation> m_MaterialBuffer{};
-	TextureImage m_BlendMap;
-	TextureImage m_BackgroundTexture;
-	TextureImage m_RTexture;
-	TextureImage m_GTexture;
-	TextureImage m_BTexture;
+	std::shared_ptr<Texture> m_BlendMap;
+	std::shared_ptr<Texture> m_BackgroundTexture;
+	std::shared_ptr<Texture> m_RTexture;
+	std::shared_ptr<Texture> m_GTexture;
+	std::shared_ptr<Texture> m_BTexture;
 
 	TerrainRenderer() = default;
 };
@@ -221,16 +218,16 @@ struct WaterRenderer
 	TextureImage m_RefractionSampledDepthTextureImage;
 	TextureImage m_RefractionColorTextureImage;
 	TextureImage m_RefractionDepthTextureImage;
-	std::vector<vk::UniqueFramebuffer> m_RefractionFrameBuffers;
+	vk::UniqueFramebuffer m_RefractionFrameBuffer;
 
 	TextureImage m_ReflectionSampledColorTextureImage;
 	TextureImage m_ReflectionSampledDepthTextureImage;
 	TextureImage m_ReflectionColorTextureImage;
 	TextureImage m_ReflectionDepthTextureImage;
-	std::vector<vk::UniqueFramebuffer> m_ReflectionFrameBuffers;
+	vk::UniqueFramebuffer m_ReflectionFrameBuffer;
 
-	TextureImage m_DuDvMapTextureImage;
-	TextureImage m_NormalMapTextureImage;
+	std::shared_ptr<Texture> m_DuDvMap;
+	std::shared_ptr<Texture> m_NormalMap;
 
 	WaterRenderer();
 
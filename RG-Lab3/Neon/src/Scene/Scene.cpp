@@ -7,6 +7,8 @@
 #include <Renderer/Context.h>
 
 #include "Allocator.h"
+#include "TextureCache.h"
+#include "UploadContext.h"
 #include "PerspectiveCameraController.h"
 
 static inline std::string GetFileName(const std::string& path)
@@ -44,20 +46,13 @@ Neon::Entity Neon::Scene::LoadSkyDome()
 	auto& transformComponent = entity.AddComponent<Transform>(glm::mat4(1.0), glm::mat4(1.0));
 	transformComponent.m_Global = glm::scale(transformComponent.m_Global, {5000, 5000, 5000});
 
-	auto cmdBuff = VulkanRenderer::BeginSingleTimeCommands();
+	UploadContext upload;
 
 	skyDomeRenderer.m_Mesh.m_VerticesCount = (uint32_t)vertices.size();
 	skyDomeRenderer.m_Mesh.m_IndicesCount = (uint32_t)indices.size();
-	skyDomeRenderer.m_Mesh.m_VertexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, vertices,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
-	skyDomeRenderer.m_Mesh.m_IndexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, indices,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	skyDomeRenderer.m_Mesh.m_Geometry = GeometryArena::Allocate(upload, vertices, indices);
 
-	Neon::VulkanRenderer::EndSingleTimeCommands(cmdBuff);
-
-	Neon::Allocator::FlushStaging();
+	upload.Submit();
 
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 
@@ -87,7 +82,10 @@ Neon::Entity Neon::Scene::LoadModel(const std::string& filename)
 	assert(scene && !(scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) && scene->mRootNode);
 	Entity rootEntity = CreateEntity(scene->mRootNode->mName.C_Str());
 	rootEntity.AddComponent<Transform>(glm::mat4(1.0), glm::mat4(1.0));
-	ProcessNode(scene, scene->mRootNode, rootEntity);
+	// Every mesh and texture of the model goes into one submission
+	UploadContext upload;
+	ProcessNode(scene, scene->mRootNode, rootEntity, upload);
+	upload.Submit();
 	return rootEntity;
 }
 
@@ -102,40 +100,32 @@ Neon::Entity Neon::Scene::LoadAnimatedModel(const std::string& filename)
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 	std::vector<Material> materials;
-	std::vector<TextureImage> textureImages;
+	std::vector<std::shared_ptr<Texture>> textures;
 	std::unordered_map<std::string, uint32_t> boneMap;
 	std::vector<glm::mat4> boneOffsets;
 
-	ProcessNode(scene, scene->mRootNode, vertices, indices, materials, textureImages, boneMap,
-				boneOffsets);
+	UploadContext upload;
+	ProcessNode(scene, scene->mRootNode, vertices, indices, materials, textures, boneMap,
+				boneOffsets, upload);
 
 	Entity entity = CreateEntity(scene->mRootNode->mName.C_Str());
 	auto& skinnedMeshRenderer =
 		entity.AddComponent<SkinnedMeshRenderer>(scene, 0, boneMap, boneOffsets);
-	skinnedMeshRenderer.m_TextureImages = std::move(textureImages);
+	skinnedMeshRenderer.m_Textures = std::move(textures);
 	auto& transformComponent = entity.AddComponent<Transform>(glm::mat4(1.0), glm::mat4(1.0));
 
-	auto cmdBuff = VulkanRenderer::BeginSingleTimeCommands();
-
-	skinnedMeshRenderer.m_BoneBuffer = Neon::Allocator::CreateBuffer(
-		sizeof(boneOffsets[0]) * skinnedMeshRenderer.m_BoneSize,
-		vk::BufferUsageFlagBits::eStorageBuffer, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	skinnedMeshRenderer.m_BoneBuffer = DynamicBuffer(
+		sizeof(boneOffsets[0]) * skinnedMeshRenderer.m_BoneSize, MAX_FRAMES_IN_FLIGHT,
+		vk::BufferUsageFlagBits::eStorageBuffer);
 
 	skinnedMeshRenderer.m_Mesh.m_VerticesCount = (uint32_t)vertices.size();
 	skinnedMeshRenderer.m_Mesh.m_IndicesCount = (uint32_t)indices.size();
-	skinnedMeshRenderer.m_Mesh.m_VertexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, vertices,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
-	skinnedMeshRenderer.m_Mesh.m_IndexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, indices,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	skinnedMeshRenderer.m_Mesh.m_Geometry = GeometryArena::Allocate(upload, vertices, indices);
 
 	skinnedMeshRenderer.m_MaterialBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, materials, vk::BufferUsageFlagBits::eStorageBuffer);
+		upload, materials, vk::BufferUsageFlagBits::eStorageBuffer);
 
-	Neon::VulkanRenderer::EndSingleTimeCommands(cmdBuff);
-
-	Neon::Allocator::FlushStaging();
+	upload.Submit();
 
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 
@@ -143,7 +133,7 @@ Neon::Entity Neon::Scene::LoadAnimatedModel(const std::string& filename)
 	bindings.emplace_back(0, vk::DescriptorType::eStorageBuffer, 1,
 						  vk::ShaderStageFlagBits::eFragment);
 	bindings.emplace_back(1, vk::DescriptorType::eCombinedImageSampler,
-						  static_cast<uint32_t>(skinnedMeshRenderer.m_TextureImages.size()),
+						  static_cast<uint32_t>(skinnedMeshRenderer.m_Textures.size()),
 						  vk::ShaderStageFlagBits::eFragment);
 	bindings.emplace_back(2, vk::DescriptorType::eStorageBuffer, 1,
 						  vk::ShaderStageFlagBits::eVertex);
@@ -152,17 +142,16 @@ Neon::Entity Neon::Scene::LoadAnimatedModel(const std::string& filename)
 												VK_WHOLE_SIZE};
 
 	std::vector<vk::DescriptorImageInfo> texturesBufferInfo;
-	texturesBufferInfo.reserve(skinnedMeshRenderer.m_TextureImages.size());
-	for (auto& textureImage : skinnedMeshRenderer.m_TextureImages)
+	texturesBufferInfo.reserve(skinnedMeshRenderer.m_Textures.size());
+	for (auto& texture : skinnedMeshRenderer.m_Textures)
 	{
-		texturesBufferInfo.push_back(textureImage.m_Descriptor);
+		texturesBufferInfo.push_back(texture->m_Descriptor);
 	}
 
-	skinnedMeshRenderer.m_DescriptorSets.resize(MAX_SWAP_CHAIN_IMAGES);
-	vk::DescriptorBufferInfo boneBufferInfo{skinnedMeshRenderer.m_BoneBuffer->m_Buffer, 0,
-											VK_WHOLE_SIZE};
-	for (int i = 0; i < MAX_SWAP_CHAIN_IMAGES; i++)
+	skinnedMeshRenderer.m_DescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
+		vk::DescriptorBufferInfo boneBufferInfo = skinnedMeshRenderer.m_BoneBuffer.GetDescriptor(i);
 		auto& wavefrontDescriptorSet = skinnedMeshRenderer.m_DescriptorSets[i];
 		wavefrontDescriptorSet.Init(device);
 		wavefrontDescriptorSet.Create(VulkanRenderer::GetDescriptorPool(), bindings);
@@ -211,22 +200,6 @@ glm::vec3 CalculateNormal(unsigned char* pixels, int texWidth, int texHeight, in
 	return glm::normalize(normal);
 }
 
-void CreateTextureImage(const std::string& filename, Neon::TextureImage& textureImage)
-{
-	textureImage.m_TextureAllocation = Neon::Allocator::CreateTextureImage(filename);
-	assert(textureImage.m_TextureAllocation);
-
-	vk::ImageView textureImageView = Neon::VulkanRenderer::CreateImageView(
-		textureImage.m_TextureAllocation->m_Image, vk::Format::eR8G8B8A8Srgb,
-		vk::ImageAspectFlagBits::eColor);
-	vk::SamplerCreateInfo samplerInfo = {
-		{}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear};
-	samplerInfo.setMaxLod(FLT_MAX);
-	vk::Sampler sampler = Neon::VulkanRenderer::CreateSampler(samplerInfo);
-	textureImage.m_Descriptor = {sampler, textureImageView,
-								 vk::ImageLayout::eShaderReadOnlyOptimal};
-}
-
 struct VertexTerrain
 {
 	glm::vec3 pos;
@@ -344,28 +317,20 @@ Neon::Entity Neon::Scene::LoadTerrain(float width, float height, float maxHeight
 	material.textureID = 0;
 	materials.push_back(material);
 
-	CreateTextureImage("textures/blendMap.png", terrainRenderer.m_BlendMap);
-	CreateTextureImage("textures/grassy2.png", terrainRenderer.m_BackgroundTexture);
-	CreateTextureImage("textures/mud.png", terrainRenderer.m_RTexture);
-	CreateTextureImage("textures/grassFlowers.png", terrainRenderer.m_GTexture);
-	CreateTextureImage("textures/path.png", terrainRenderer.m_BTexture);
-
-	auto cmdBuff = VulkanRenderer::BeginSingleTimeCommands();
+	UploadContext upload;
+	terrainRenderer.m_BlendMap = TextureCache::Get(upload, "textures/blendMap.png", false);
+	terrainRenderer.m_BackgroundTexture = TextureCache::Get(upload, "textures/grassy2.png");
+	terrainRenderer.m_RTexture = TextureCache::Get(upload, "textures/mud.png");
+	terrainRenderer.m_GTexture = TextureCache::Get(upload, "textures/grassFlowers.png");
+	terrainRenderer.m_BTexture = TextureCache::Get(upload, "textures/path.png");
 
 	terrainRenderer.m_Mesh.m_VerticesCount = (uint32_t)vertices.size();
 	terrainRenderer.m_Mesh.m_IndicesCount = (uint32_t)indices.size();
-	terrainRenderer.m_Mesh.m_VertexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, vertices,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
-	terrainRenderer.m_Mesh.m_IndexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, indices,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	terrainRenderer.m_Mesh.m_Geometry = GeometryArena::Allocate(upload, vertices, indices);
 	terrainRenderer.m_MaterialBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, materials, vk::BufferUsageFlagBits::eStorageBuffer);
-
-	VulkanRenderer::EndSingleTimeCommands(cmdBuff);
+		upload, materials, vk::BufferUsageFlagBits::eStorageBuffer);
 
-	Allocator::FlushStaging();
+	upload.Submit();
 
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 
@@ -386,20 +351,20 @@ Neon::Entity Neon::Scene::LoadTerrain(float width, float height, float maxHeight
 	vk::DescriptorBufferInfo materialBufferInfo{terrainRenderer.m_MaterialBuffer->m_Buffer, 0,
 												VK_WHOLE_SIZE};
 
-	terrainRenderer.m_DescriptorSets.resize(MAX_SWAP_CHAIN_IMAGES);
-	for (int i = 0; i < MAX_SWAP_CHAIN_IMAGES; i++)
+	terrainRenderer.m_DescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		auto& wavefrontDescriptorSet = terrainRenderer.m_DescriptorSets[i];
 		wavefrontDescriptorSet.Init(device);
 		wavefrontDescriptorSet.Create(VulkanRenderer::GetDescriptorPool(), bindings);
 		std::vector<vk::WriteDescriptorSet> descriptorWrites = {
 			wavefrontDescriptorSet.CreateWrite(0, &materialBufferInfo, 0),
-			wavefrontDescriptorSet.CreateWrite(1, &terrainRenderer.m_BlendMap.m_Descriptor, 0),
-			wavefrontDescriptorSet.CreateWrite(2, &terrainRenderer.m_BackgroundTexture.m_Descriptor,
-											   0),
-			wavefrontDescriptorSet.CreateWrite(3, &terrainRenderer.m_RTexture.m_Descriptor, 0),
-			wavefrontDescriptorSet.CreateWrite(4, &terrainRenderer.m_GTexture.m_Descriptor, 0),
-			wavefrontDescriptorSet.CreateWrite(5, &terrainRenderer.m_BTexture.m_Descriptor, 0)};
+			wavefrontDescriptorSet.CreateWrite(1, &terrainRenderer.m_BlendMap->m_Descriptor, 0),
+			wavefrontDescriptorSet.CreateWrite(
+				2, &terrainRenderer.m_BackgroundTexture->m_Descriptor, 0),
+			wavefrontDescriptorSet.CreateWrite(3, &terrainRenderer.m_RTexture->m_Descriptor, 0),
+			wavefrontDescriptorSet.CreateWrite(4, &terrainRenderer.m_GTexture->m_Descriptor, 0),
+			wavefrontDescriptorSet.CreateWrite(5, &terrainRenderer.m_BTexture->m_Descriptor, 0)};
 		wavefrontDescriptorSet.Update(descriptorWrites);
 	}
 
@@ -469,24 +434,20 @@ Neon::Entity Neon::Scene::LoadWater()
 	material.specular = {0.1, 0.1, 0.1};
 	material.shininess = 20;
 
-	auto cmdBuff = VulkanRenderer::BeginSingleTimeCommands();
+	UploadContext upload;
 
 	waterRenderer.m_Mesh.m_VerticesCount = (uint32_t)vertices.size();
 	waterRenderer.m_Mesh.m_IndicesCount = (uint32_t)indices.size();
-	waterRenderer.m_Mesh.m_VertexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, vertices,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
-	waterRenderer.m_Mesh.m_IndexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, indices,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	waterRenderer.m_Mesh.m_Geometry = GeometryArena::Allocate(upload, vertices, indices);
 
 	std::vector<Material> materials = {material};
 	waterRenderer.m_MaterialBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, materials, vk::BufferUsageFlagBits::eStorageBuffer);
+		upload, materials, vk::BufferUsageFlagBits::eStorageBuffer);
 
-	VulkanRenderer::EndSingleTimeCommands(cmdBuff);
+	waterRenderer.m_DuDvMap = TextureCache::Get(upload, "textures/waterDUDV.png", false);
+	waterRenderer.m_NormalMap = TextureCache::Get(upload, "textures/normalMap.png", false);
 
-	Allocator::FlushStaging();
+	upload.Submit();
 
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 
@@ -507,11 +468,8 @@ Neon::Entity Neon::Scene::LoadWater()
 	vk::DescriptorBufferInfo materialBufferInfo{waterRenderer.m_MaterialBuffer->m_Buffer, 0,
 												VK_WHOLE_SIZE};
 
-	CreateTextureImage("textures/waterDUDV.png", waterRenderer.m_DuDvMapTextureImage);
-	CreateTextureImage("textures/normalMap.png", waterRenderer.m_NormalMapTextureImage);
-
-	waterRenderer.m_DescriptorSets.resize(MAX_SWAP_CHAIN_IMAGES);
-	for (int i = 0; i < MAX_SWAP_CHAIN_IMAGES; i++)
+	waterRenderer.m_DescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		auto& wavefrontDescriptorSet = waterRenderer.m_DescriptorSets[i];
 		wavefrontDescriptorSet.Init(device);
@@ -522,10 +480,8 @@ Neon::Entity Neon::Scene::LoadWater()
 				1, &waterRenderer.m_RefractionColorTextureImage.m_Descriptor, 0),
 			wavefrontDescriptorSet.CreateWrite(
 				2, &waterRenderer.m_ReflectionColorTextureImage.m_Descriptor, 0),
-			wavefrontDescriptorSet.CreateWrite(3, &waterRenderer.m_DuDvMapTextureImage.m_Descriptor,
-											   0),
-			wavefrontDescriptorSet.CreateWrite(4, &waterRenderer.m_NormalMapTextureImage.m_Descriptor,
-											   0),
+			wavefrontDescriptorSet.CreateWrite(3, &waterRenderer.m_DuDvMap->m_Descriptor, 0),
+			wavefrontDescriptorSet.CreateWrite(4, &waterRenderer.m_NormalMap->m_Descriptor, 0),
 			wavefrontDescriptorSet.CreateWrite(5, &waterRenderer.m_RefractionDepthTextureImage.m_Descriptor,
 											   0)};
 		wavefrontDescriptorSet.Update(descriptorWrites);
@@ -589,7 +545,7 @@ void Neon::Scene::OnUpdate(float ts, Neon::PerspectiveCameraController controlle
 		{
 			waterHeight += 0.1;
 		}
-		VulkanRenderer::BeginScene(waterRenderer.m_RefractionFrameBuffers,
+		VulkanRenderer::BeginScene(waterRenderer.m_RefractionFrameBuffer,
 								   refractionReflectionResolution, clearColor, camera,
 								   {0, yNormal, 0, waterHeight}, pointLight, lightIntensity,
 								   lightDirection, lightPosition);
@@ -600,7 +556,7 @@ void Neon::Scene::OnUpdate(float ts, Neon::PerspectiveCameraController controlle
 		camera.Translate({0, translation, 0});
 		camera.InvertPitch();
 
-		VulkanRenderer::BeginScene(waterRenderer.m_ReflectionFrameBuffers,
+		VulkanRenderer::BeginScene(waterRenderer.m_ReflectionFrameBuffer,
 								   refractionReflectionResolution, clearColor, camera,
 								   {0, -yNormal, 0, -waterHeight}, pointLight, lightIntensity,
 								   lightDirection, lightPosition);
@@ -609,7 +565,7 @@ void Neon::Scene::OnUpdate(float ts, Neon::PerspectiveCameraController controlle
 	}
 
 	auto camera = controller.GetCamera();
-	VulkanRenderer::BeginScene(VulkanRenderer::GetOffscreenFramebuffers(),
+	VulkanRenderer::BeginScene(VulkanRenderer::GetOffscreenFramebuffer(),
 							   VulkanRenderer::GetExtent2D(), clearColor, camera, {0, 1, 0, 100000},
 							   pointLight, lightIntensity, lightDirection, lightPosition);
 	Render(camera, VulkanRenderer::GetExtent2D());
@@ -656,7 +612,8 @@ void Neon::Scene::Render(Neon::PerspectiveCamera camera, vk::Extent2D extent)
 	}
 }
 
-void Neon::Scene::ProcessNode(const aiScene* scene, aiNode* node, Neon::Entity parent)
+void Neon::Scene::ProcessNode(const aiScene* scene, aiNode* node, Neon::Entity parent,
+							  UploadContext& upload)
 {
 	auto newParent = CreateEntity(node->mName.C_Str());
 	newParent.AddComponent<Transform>(glm::mat4(1.0),
@@ -665,11 +622,11 @@ void Neon::Scene::ProcessNode(const aiScene* scene, aiNode* node, Neon::Entity p
 	for (int i = 0; i < node->mNumMeshes; i++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessMesh(scene, mesh, newParent);
+		ProcessMesh(scene, mesh, newParent, upload);
 	}
 	for (int i = 0; i < node->mNumChildren; i++)
 	{
-		ProcessNode(scene, node->mChildren[i], newParent);
+		ProcessNode(scene, node->mChildren[i], newParent, upload);
 	}
 }
 
@@ -689,19 +646,20 @@ void Neon::Scene::ProcessNode(const aiScene* scene, aiNode* node, std::vector<Ve
 
 void Neon::Scene::ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
 							  std::vector<uint32_t>& indices, std::vector<Material>& materials,
-							  std::vector<TextureImage>& textureImages,
+							  std::vector<std::shared_ptr<Texture>>& textures,
 							  std::unordered_map<std::string, uint32_t>& boneMap,
-							  std::vector<glm::mat4>& boneOffsets)
+							  std::vector<glm::mat4>& boneOffsets, UploadContext& upload)
 {
 	for (int i = 0; i < node->mNumMeshes; i++)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		ProcessMesh(scene, mesh, vertices, indices, materials, textureImages, boneMap, boneOffsets);
+		ProcessMesh(scene, mesh, vertices, indices, materials, textures, boneMap, boneOffsets,
+					upload);
 	}
 	for (int i = 0; i < node->mNumChildren; i++)
 	{
-		ProcessNode(scene, node->mChildren[i], vertices, indices, materials, textureImages, boneMap,
-					boneOffsets);
+		ProcessNode(scene, node->mChildren[i], vertices, indices, materials, textures, boneMap,
+					boneOffsets, upload);
 	}
 }
 
@@ -732,40 +690,19 @@ void Neon::Scene::ProcessMesh(aiMesh* mesh, std::vector<Vertex>& vertices,
 	}
 }
 
-void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent)
+void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent,
+							  UploadContext& upload)
 {
 	assert(parent.HasComponent<Transform>());
 
-	std::vector<uint32_t> indices;
+	uint32_t indicesCount = 0;
 	for (int i = 0; i < mesh->mNumFaces; i++)
 	{
 		// FIXME: for now just ignore faces with number of indices not equal to 3
-		aiFace face = mesh->mFaces[i];
-		if (face.mNumIndices != 3) { continue; }
-		for (int j = 0; j < face.mNumIndices; j++)
-		{
-			indices.push_back(face.mIndices[j]);
-		}
+		if (mesh->mFaces[i].mNumIndices == 3) { indicesCount += 3; }
 	}
 
-	if (indices.empty()) { return; }
-
-	std::vector<Vertex> vertices;
-	for (int i = 0; i < mesh->mNumVertices; i++)
-	{
-		Vertex vertex{};
-		vertex.pos = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
-		vertex.norm = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
-		vertex.matID = 0;
-		// TODO: for now just use first texture coordinate
-		if (mesh->mTextureCoords[0])
-		{ vertex.texCoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y}; }
-		else
-		{
-			vertex.texCoord = {0.0f, 0.0f};
-		}
-		vertices.push_back(vertex);
-	}
+	if (indicesCount == 0) { return; }
 
 	Entity entity = CreateEntity(mesh->mName.C_Str());
 	auto& meshRenderer = entity.AddComponent<MeshRenderer>();
@@ -790,52 +727,59 @@ void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent)
 	material.textureID = 0;
 	materials.push_back(material);
 
-	std::unique_ptr<ImageAllocation> imageAllocation;
 	if (aiMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
 	{
 		// TODO: for now just load first diffuse texture
 		aiString txt;
 		aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &txt);
 		std::string texturePath = "textures/" + GetFileName(txt.C_Str());
-		imageAllocation = Neon::Allocator::CreateTextureImage(texturePath);
+		meshRenderer.m_Textures.push_back(TextureCache::Get(upload, texturePath));
 	}
 	else
 	{
-		int texWidth = 1, texHeight = 1;
-		auto* color = new glm::u8vec4(255, 255, 255, 255);
-		auto* pixels = reinterpret_cast<stbi_uc*>(color);
-		imageAllocation = Neon::Allocator::CreateTextureImage(pixels, texWidth, texHeight);
+		meshRenderer.m_Textures.push_back(
+			TextureCache::GetSolidColor(upload, glm::u8vec4(255, 255, 255, 255)));
 	}
-	assert(imageAllocation);
 
-	vk::ImageView textureImageView = Neon::VulkanRenderer::CreateImageView(
-		imageAllocation->m_Image, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
-	vk::SamplerCreateInfo samplerInfo = {
-		{}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear};
-	samplerInfo.setMaxLod(FLT_MAX);
-	vk::Sampler sampler = Neon::VulkanRenderer::CreateSampler(samplerInfo);
-	vk::DescriptorImageInfo desc{sampler, textureImageView,
-								 vk::ImageLayout::eShaderReadOnlyOptimal};
-
-	meshRenderer.m_TextureImages.emplace_back(desc, std::move(imageAllocation));
+	// Geometry is written straight into staging memory
+	StagingAllocation vertexStaging =
+		Allocator::AllocateStaging(mesh->mNumVertices * sizeof(Vertex));
+	auto* vertices = vertexStaging.As<Vertex>();
+	for (int i = 0; i < mesh->mNumVertices; i++)
+	{
+		Vertex vertex{};
+		vertex.pos = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
+		vertex.norm = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
+		vertex.matID = 0;
+		// TODO: for now just use first texture coordinate
+		if (mesh->mTextureCoords[0])
+		{ vertex.texCoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y}; }
+		else
+		{
+			vertex.texCoord = {0.0f, 0.0f};
+		}
+		vertices[i] = vertex;
+	}
 
-	auto cmdBuff = VulkanRenderer::BeginSingleTimeCommands();
+	StagingAllocation indexStaging = Allocator::AllocateStaging(indicesCount * sizeof(uint32_t));
+	auto* indices = indexStaging.As<uint32_t>();
+	for (int i = 0; i < mesh->mNumFaces; i++)
+	{
+		aiFace face = mesh->mFaces[i];
+		if (face.mNumIndices != 3) { continue; }
+		for (int j = 0; j < face.mNumIndices; j++)
+		{
+			*indices++ = face.mIndices[j];
+		}
+	}
 
-	meshRenderer.m_Mesh.m_VerticesCount = (uint32_t)vertices.size();
-	meshRenderer.m_Mesh.m_IndicesCount = (uint32_t)indices.size();
-	meshRenderer.m_Mesh.m_VertexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, vertices,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
-	meshRenderer.m_Mesh.m_IndexBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, indices,
-		vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+	meshRenderer.m_Mesh.m_VerticesCount = mesh->mNumVertices;
+	meshRenderer.m_Mesh.m_IndicesCount = indicesCount;
+	meshRenderer.m_Mesh.m_Geometry =
+		GeometryArena::Allocate(upload, vertexStaging, sizeof(Vertex), indexStaging);
 
 	meshRenderer.m_MaterialBuffer = Allocator::CreateDeviceLocalBuffer(
-		cmdBuff, materials, vk::BufferUsageFlagBits::eStorageBuffer);
-
-	VulkanRenderer::EndSingleTimeCommands(cmdBuff);
-
-	Allocator::FlushStaging();
+		upload, materials, vk::BufferUsageFlagBits::eStorageBuffer);
 
 	const auto& device = Neon::Context::GetInstance().GetLogicalDevice().GetHandle();
 
@@ -843,21 +787,21 @@ void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent)
 	bindings.emplace_back(0, vk::DescriptorType::eStorageBuffer, 1,
 						  vk::ShaderStageFlagBits::eFragment);
 	bindings.emplace_back(1, vk::DescriptorType::eCombinedImageSampler,
-						  static_cast<uint32_t>(meshRenderer.m_TextureImages.size()),
+						  static_cast<uint32_t>(meshRenderer.m_Textures.size()),
 						  vk::ShaderStageFlagBits::eFragment);
 
 	vk::DescriptorBufferInfo materialBufferInfo{meshRenderer.m_MaterialBuffer->m_Buffer, 0,
 												VK_WHOLE_SIZE};
 
 	std::vector<vk::DescriptorImageInfo> texturesBufferInfo;
-	texturesBufferInfo.reserve(meshRenderer.m_TextureImages.size());
-	for (auto& texture : meshRenderer.m_TextureImages)
+	texturesBufferInfo.reserve(meshRenderer.m_Textures.size());
+	for (auto& texture : meshRenderer.m_Textures)
 	{
-		texturesBufferInfo.push_back(texture.m_Descriptor);
+		texturesBufferInfo.push_back(texture->m_Descriptor);
 	}
 
-	meshRenderer.m_DescriptorSets.resize(MAX_SWAP_CHAIN_IMAGES);
-	for (int i = 0; i < MAX_SWAP_CHAIN_IMAGES; i++)
+	meshRenderer.m_DescriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
+	for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		auto& wavefrontDescriptorSet = meshRenderer.m_DescriptorSets[i];
 		wavefrontDescriptorSet.Init(device);
@@ -885,9 +829,9 @@ void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent)
 
 void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, std::vector<Vertex>& vertices,
 							  std::vector<uint32_t>& indices, std::vector<Material>& materials,
-							  std::vector<TextureImage>& textureImages,
+							  std::vector<std::shared_ptr<Texture>>& textures,
 							  std::unordered_map<std::string, uint32_t>& boneMap,
-							  std::vector<glm::mat4>& boneOffsets)
+							  std::vector<glm::mat4>& boneOffsets, UploadContext& upload)
 {
 	int meshSizeBefore = vertices.size();
 	int newIndicesCount = 0;
@@ -966,33 +910,23 @@ void Neon::Scene::ProcessMesh(const aiScene* scene, aiMesh* mesh, std::vector<Ve
 	float shininess;
 	aiMaterial->Get(AI_MATKEY_SHININESS, shininess);
 	material.shininess = shininess;
-	material.textureID = textureImages.size();
-	materials.push_back(material);
 
-	std::unique_ptr<ImageAllocation> imageAllocation;
+	std::shared_ptr<Texture> texture;
 	if (aiMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
 	{
 		// TODO: for now just load first diffuse texture
 		aiString txt;
 		aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &txt);
 		std::string texturePath = "textures/" + GetFileName(txt.C_Str());
-		imageAllocation = Neon::Allocator::CreateTextureImage(texturePath);
+		texture = TextureCache::Get(upload, texturePath);
 	}
 	else
 	{
-		int texWidth = 1, texHeight = 1;
-		auto* color = new glm::u8vec4(255, 255, 255, 255);
-		auto* pixels = reinterpret_cast<stbi_uc*>(color);
-		imageAllocation = Neon::Allocator::CreateTextureImage(pixels, texWidth, texHeight);
-	}
-	assert(imageAllocation);
-	vk::ImageView textureImageView = Neon::VulkanRenderer::CreateImageView(
-		imageAllocation->m_Image, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
-	vk::SamplerCreateInfo samplerInfo = {
-		{}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear};
-	samplerInfo.setMaxLod(FLT_MAX);
-	vk::Sampler sampler = Neon::VulkanRenderer::CreateSampler(samplerInfo);
-	vk::DescriptorImageInfo desc{sampler, textureImageView,
-								 vk::ImageLayout::eShaderReadOnlyOptimal};
-	textureImages.emplace_back(desc, std::move(imageAllocation));
+		texture = TextureCache::GetSolidColor(upload, glm::u8vec4(255, 255, 255, 255));
+	}
+	// Materials sharing a texture share its slot in the descriptor array
+	auto slot = std::find(textures.begin(), textures.end(), texture);
+	material.textureID = static_cast<int>(slot - textures.begin());
+	if (slot == textures.end()) textures.push_back(std::move(texture));
+	materials.push_back(material);
 }
@@ -17,6 +17,7 @@
 namespace Neon
 {
 class Entity;
+class UploadContext;
 
 struct Vertex
 {
@@ -99,22 +100,22 @@ public:
 				  glm::vec3 lightPosition);
 
 private:
-	void ProcessNode(const aiScene* scene, aiNode* node, Entity parent);
+	void ProcessNode(const aiScene* scene, aiNode* node, Entity parent, UploadContext& upload);
 	void ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
 					 std::vector<uint32_t>& indices);
 	void ProcessNode(const aiScene* scene, aiNode* node, std::vector<Vertex>& vertices,
 					 std::vector<uint32_t>& indices, std::vector<Material>& materials,
-					 std::vector<TextureImage>& textureImages,
+					 std::vector<std::shared_ptr<Texture>>& textures,
 					 std::unordered_map<std::string, uint32_t>& boneMap,
-					 std::vector<glm::mat4>& boneOffsets);
+					 std::vector<glm::mat4>& boneOffsets, UploadContext& upload);
 	static void ProcessMesh(aiMesh* mesh, std::vector<Vertex>& vertices,
 							std::vector<uint32_t>& indices);
-	void ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent);
+	void ProcessMesh(const aiScene* scene, aiMesh* mesh, Entity parent, UploadContext& upload);
 	static void ProcessMesh(const aiScene* scene, aiMesh* mesh, std::vector<Vertex>& vertices,
 							std::vector<uint32_t>& indices, std::vector<Material>& materials,
-							std::vector<TextureImage>& textureImages,
+							std::vector<std::shared_ptr<Texture>>& textures,
 							std::unordered_map<std::string, uint32_t>& boneMap,
-							std::vector<glm::mat4>& boneOffsets);
+							std::vector<glm::mat4>& boneOffsets, UploadContext& upload);
 	void Render(Neon::PerspectiveCamera camera, vk::Extent2D extent);
 
 private:
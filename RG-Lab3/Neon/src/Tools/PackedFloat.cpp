@@ -0,0 +1,92 @@
+#include "PackedFloat.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr int32_t s_ExponentBias = 15;
+constexpr uint32_t s_ExponentMask = 0x1f;
+} // namespace
+
+uint32_t Neon::PackUfloat(float value, uint32_t mantissaBits)
+{
+	// Exponent 31 is reserved for infinity and NaN
+	const uint32_t maxBits = (30u << mantissaBits) | ((1u << mantissaBits) - 1);
+	if (!(value > 0.0f)) return 0;
+	if (value >= UnpackUfloat(maxBits, mantissaBits)) return maxBits;
+
+	// Denormals are scaled like the smallest normal exponent, just without the implicit one
+	int exponent;
+	std::frexp(value, &exponent);
+	exponent = std::max(exponent - 1, 1 - s_ExponentBias);
+
+	// The mantissa includes the implicit one of normals, so adding it to the exponent field one
+	// below the real exponent gives the right encoding, and a mantissa that rounds up to the next
+	// power of two carries into the exponent
+	const auto mantissa = static_cast<uint32_t>(
+		std::nearbyint(std::ldexp(value, static_cast<int>(mantissaBits) - exponent)));
+	const uint32_t bits =
+		(static_cast<uint32_t>(exponent + s_ExponentBias - 1) << mantissaBits) + mantissa;
+	return std::min(bits, maxBits);
+}
+
+float Neon::UnpackUfloat(uint32_t bits, uint32_t mantissaBits)
+{
+	const uint32_t exponent = (bits >> mantissaBits) & s_ExponentMask;
+	const uint32_t mantissa = bits & ((1u << mantissaBits) - 1);
+	if (exponent == 0)
+		return std::ldexp(static_cast<float>(mantissa),
+						  1 - s_ExponentBias - static_cast<int>(mantissaBits));
+	if (exponent == s_ExponentMask) return mantissa ? NAN : INFINITY;
+	return std::ldexp(static_cast<float>((1u << mantissaBits) | mantissa),
+					  static_cast<int>(exponent) - s_ExponentBias - static_cast<int>(mantissaBits));
+}
+
+uint32_t Neon::PackB10G11R11(const glm::vec3& color)
+{
+	return PackUfloat(color.r, 6) | PackUfloat(color.g, 6) << 11 | PackUfloat(color.b, 5) << 22;
+}
+
+glm::vec3 Neon::UnpackB10G11R11(uint32_t packed)
+{
+	return {UnpackUfloat(packed & 0x7ff, 6), UnpackUfloat((packed >> 11) & 0x7ff, 6),
+			UnpackUfloat(packed >> 22, 5)};
+}
+
+uint32_t Neon::PackE5B9G9R9(const glm::vec3& color)
+{
+	constexpr int32_t mantissaBits = 9;
+	constexpr int32_t maxExponent = 31;
+	const float sharedExpMax = std::ldexp(static_cast<float>((1 << mantissaBits) - 1),
+										  maxExponent - s_ExponentBias - mantissaBits);
+
+	// Negative values and NaN become 0
+	auto clampChannel = [sharedExpMax](float c) {
+		return c > 0.0f ? std::min(c, sharedExpMax) : 0.0f;
+	};
+	const glm::vec3 clamped{clampChannel(color.r), clampChannel(color.g), clampChannel(color.b)};
+	const float maxChannel = std::max({clamped.r, clamped.g, clamped.b});
+	if (maxChannel == 0.0f) return 0;
+
+	// floor(log2(maxChannel)) is one below the frexp exponent
+	int exponent;
+	std::frexp(maxChannel, &exponent);
+	int32_t sharedExp = std::max(-s_ExponentBias - 1, exponent - 1) + 1 + s_ExponentBias;
+	auto quantize = [&sharedExp](float c) {
+		return static_cast<uint32_t>(
+			std::floor(std::ldexp(c, mantissaBits + s_ExponentBias - sharedExp) + 0.5f));
+	};
+	if (quantize(maxChannel) == 1u << mantissaBits) sharedExp++;
+
+	return quantize(clamped.r) | quantize(clamped.g) << 9 | quantize(clamped.b) << 18 |
+		   static_cast<uint32_t>(sharedExp) << 27;
+}
+
+glm::vec3 Neon::UnpackE5B9G9R9(uint32_t packed)
+{
+	const int exponent = static_cast<int>(packed >> 27) - s_ExponentBias - 9;
+	return {std::ldexp(static_cast<float>(packed & 0x1ff), exponent),
+			std::ldexp(static_cast<float>((packed >> 9) & 0x1ff), exponent),
+			std::ldexp(static_cast<float>((packed >> 18) & 0x1ff), exponent)};
+}
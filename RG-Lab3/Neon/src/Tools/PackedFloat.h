@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace Neon
+{
+// Encoders for the packed unsigned float formats HDR textures are stored in. Negative values and
+// NaN become 0, values above the largest finite one and infinity are clamped to it, and values
+// below the smallest normal one are stored as denormals, all rounded to nearest even.
+
+// Unsigned float with 5 exponent bits and 6 (11-bit) or 5 (10-bit) mantissa bits
+uint32_t PackUfloat(float value, uint32_t mantissaBits);
+float UnpackUfloat(uint32_t bits, uint32_t mantissaBits);
+
+// VK_FORMAT_B10G11R11_UFLOAT_PACK32, red in the low 11 bits
+uint32_t PackB10G11R11(const glm::vec3& color);
+glm::vec3 UnpackB10G11R11(uint32_t packed);
+
+// VK_FORMAT_E5B9G9R9_UFLOAT_PACK32, three 9-bit mantissas with a shared exponent, encoded with
+// the shared exponent algorithm of the Vulkan specification
+uint32_t PackE5B9G9R9(const glm::vec3& color);
+glm::vec3 UnpackE5B9G9R9(uint32_t packed);
+} // namespace Neon
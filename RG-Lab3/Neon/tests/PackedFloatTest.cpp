@@ -0,0 +1,132 @@
+// Round trips the packed HDR texture encoders through their decoders, including the denormal and
+// overflow ranges. Returns non-zero when a check fails.
+
+#include "Tools/PackedFloat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+int s_Failures = 0;
+
+void Check(bool condition, const char* what, double value, double result)
+{
+	if (condition) return;
+	std::printf("FAILED: %s, input %g, result %g\n", what, value, result);
+	s_Failures++;
+}
+
+void TestUfloat(uint32_t mantissaBits, float maxValue)
+{
+	const uint32_t maxBits = (30u << mantissaBits) | ((1u << mantissaBits) - 1);
+	const float smallestNormal = std::ldexp(1.0f, -14);
+	const float denormalStep = std::ldexp(1.0f, -14 - static_cast<int>(mantissaBits));
+
+	// Every finite encoding, denormals included, decodes to a value that encodes to it again
+	for (uint32_t bits = 0; bits <= maxBits; bits++)
+	{
+		const float value = Neon::UnpackUfloat(bits, mantissaBits);
+		Check(Neon::PackUfloat(value, mantissaBits) == bits, "exact round trip", value, bits);
+	}
+	Check(Neon::UnpackUfloat(maxBits, mantissaBits) == maxValue, "largest value", maxValue,
+		  Neon::UnpackUfloat(maxBits, mantissaBits));
+
+	// Arbitrary values land within half a step of the input, log-uniform from below the
+	// denormals up to the largest value
+	std::mt19937 random(mantissaBits);
+	std::uniform_real_distribution<float> exponent(-30.0f, 16.0f);
+	for (int i = 0; i < 1000000; i++)
+	{
+		const float value = std::min(std::exp2(exponent(random)), maxValue);
+		const float result =
+			Neon::UnpackUfloat(Neon::PackUfloat(value, mantissaBits), mantissaBits);
+		const float tolerance = value < smallestNormal
+									? denormalStep * 0.5f
+									: value * std::ldexp(1.0f, -static_cast<int>(mantissaBits) - 1);
+		Check(std::abs(result - value) <= tolerance, "nearest value", value, result);
+	}
+
+	// Values glm 0.9.9.7 turned into bright texels or infinity
+	for (float value : {1e-7f, 1e-6f, 1e-5f, 3e-5f, 6e-5f})
+	{
+		const float result =
+			Neon::UnpackUfloat(Neon::PackUfloat(value, mantissaBits), mantissaBits);
+		Check(std::abs(result - value) <= denormalStep * 0.5f, "denormal", value, result);
+	}
+
+	// Overflow clamps to the largest finite value, negatives and NaN become 0
+	for (float value : {maxValue * 1.001f, 1e10f, INFINITY})
+	{
+		const float result =
+			Neon::UnpackUfloat(Neon::PackUfloat(value, mantissaBits), mantissaBits);
+		Check(result == maxValue, "overflow", value, result);
+	}
+	for (float value : {-1.0f, -1e-6f, -0.0f, NAN})
+		Check(Neon::PackUfloat(value, mantissaBits) == 0, "negative or NaN", value, 0.0);
+}
+
+void TestB10G11R11()
+{
+	const glm::vec3 color{1e-6f, 1234.5f, 70000.0f};
+	const glm::vec3 result = Neon::UnpackB10G11R11(Neon::PackB10G11R11(color));
+	Check(std::abs(result.r - color.r) <= std::ldexp(1.0f, -21), "B10G11R11 red", color.r,
+		  result.r);
+	Check(std::abs(result.g - color.g) <= color.g / 128.0f, "B10G11R11 green", color.g,
+		  result.g);
+	Check(result.b == 64512.0f, "B10G11R11 blue", color.b, result.b);
+}
+
+void TestE5B9G9R9()
+{
+	const float maxValue = 65408.0f;
+
+	// The shared exponent follows the largest channel, every channel is within half of its step
+	std::mt19937 random(9);
+	std::uniform_real_distribution<float> exponent(-30.0f, 16.0f);
+	for (int i = 0; i < 1000000; i++)
+	{
+		const glm::vec3 color{std::min(std::exp2(exponent(random)), maxValue),
+							  std::min(std::exp2(exponent(random)), maxValue),
+							  std::min(std::exp2(exponent(random)), maxValue)};
+		const glm::vec3 result = Neon::UnpackE5B9G9R9(Neon::PackE5B9G9R9(color));
+		const float largest = std::max({color.r, color.g, color.b});
+		int largestExponent;
+		std::frexp(largest, &largestExponent);
+		// One step is 2^(floor(log2(largest)) - 8), doubled when largest rounds up to 512 steps
+		float step = std::ldexp(1.0f, std::max(largestExponent - 1, -16) - 8);
+		if (std::floor(largest / step + 0.5f) == 512.0f) step *= 2.0f;
+		for (int c = 0; c < 3; c++)
+			Check(std::abs(result[c] - color[c]) <= step * 0.5f, "E5B9G9R9 channel", color[c],
+				  result[c]);
+	}
+
+	// glm 0.9.9.7 clamped this to 32768
+	const glm::vec3 bright = Neon::UnpackE5B9G9R9(Neon::PackE5B9G9R9({50000.0f, 1.0f, 2.0f}));
+	Check(std::abs(bright.r - 50000.0f) <= 64.0f, "E5B9G9R9 bright red", 50000.0, bright.r);
+
+	const glm::vec3 overflow = Neon::UnpackE5B9G9R9(Neon::PackE5B9G9R9({1e10f, INFINITY, 1.0f}));
+	Check(overflow.r == maxValue, "E5B9G9R9 overflow", 1e10, overflow.r);
+	Check(overflow.g == maxValue, "E5B9G9R9 infinity", INFINITY, overflow.g);
+
+	const glm::vec3 dark = Neon::UnpackE5B9G9R9(Neon::PackE5B9G9R9({1e-6f, 0.0f, -1.0f}));
+	Check(std::abs(dark.r - 1e-6f) <= std::ldexp(1.0f, -25), "E5B9G9R9 dark", 1e-6, dark.r);
+	Check(dark.b == 0.0f, "E5B9G9R9 negative", -1.0, dark.b);
+	Check(Neon::PackE5B9G9R9({NAN, 0.0f, 0.0f}) == 0, "E5B9G9R9 NaN", NAN, 0.0);
+}
+} // namespace
+
+int main()
+{
+	TestUfloat(6, 65024.0f);
+	TestUfloat(5, 64512.0f);
+	TestB10G11R11();
+	TestE5B9G9R9();
+
+	if (s_Failures) std::printf("%d checks failed\n", s_Failures);
+	else
+		std::printf("All packed float checks passed\n");
+	return s_Failures ? 1 : 0;
+}